@@ -2,26 +2,27 @@
 
 #include "softshader.hh"
 
-static uint32_t shade(const ss::V2 coord)
+using F = ss::Vf<ss::lanes>;
+using V2 = ss::V2p<ss::lanes>;
+using V3 = ss::V3p<ss::lanes>;
+
+static ss::Vu<ss::lanes> shade(const V2 coord, const ss::Uniforms& u)
 {
-    const auto per = coord / ss::res;
-    auto c = ss::V3 {};
-    auto l = 0.f;
-    auto z = ss::uptime();
+    const auto per = coord / u.res;
+    auto c = V3 {};
+    auto l = F {};
+    auto z = u.time;
     for(int i = 0; i < 3; i++)
     {
-        const auto p = (per - 0.5f) * ss::V2 { ss::res.x / ss::res.y, 1.f };
+        const auto p = (per - 0.5f) * ss::V2 { u.res.x / u.res.y, 1.f };
         l = ss::length(p);
         z += 0.07f;
         const auto uv = per + p / l * (ss::sin(z) + 1.f) * ss::abs(ss::sin(l * 9.f - z * 2.f));
         const auto cc = ss::length(ss::abs(ss::mod(uv, 1.f) - 0.5f));
-        c[i] = (cc == 0.f) ? 1.f : (0.01f / cc);
+        c[i] = ss::select(cc == 0.f, 1.f, 0.01f / cc);
     }
     const auto v = c / l;
-    return v.color(ss::uptime());
+    return v.color(u.time);
 }
 
-int main()
-{
-    ss::run(shade);
-}
+static const auto enrolled = ss::enroll("creation", ss::shader<shade>);
@@ -0,0 +1,8 @@
+#include "softshader.hh"
+
+// EVERY SHADER FILE LINKED IN REGISTERS ITSELF BY NAME. SEE SS::LAUNCH FOR THE ARGUMENTS.
+
+int main(int argc, char** argv)
+{
+    return ss::launch(argc, argv);
+}
@@ -0,0 +1,126 @@
+// MICROBENCHMARKS OF THE STRUCTURE OF ARRAYS BATCH OPERATIONS AGAINST THE SCALAR OPERATORS OVER AN ARRAY OF STRUCTS,
+// OF PROCEDURAL VALUE NOISE AGAINST THE LOOKUP TEXTURES, AND OF SHADERS CALLED THROUGH A POINTER AGAINST SS::SHADER.
+// PRINTS ONE JSON LINE PER OPERATION. SS_MICRO_N SETS THE ELEMENT COUNT AND SS_MICRO_REPS THE REPETITIONS (BEST IS KEPT).
+
+#include "softshader.hh"
+
+namespace
+{
+    using ss::V3;
+    using F = ss::Vf<ss::lanes>;
+    using V2p = ss::V2p<ss::lanes>;
+
+    template<typename F>
+    double best(int reps, F f)
+    {
+        auto fastest = 1e30;
+        for(int r = 0; r < reps; r++)
+            fastest = std::min(fastest, ss::timed(f));
+        return fastest;
+    }
+
+    template<typename Scalar, typename Batch>
+    void compare(const char* op, int n, int reps, Scalar scalar, Batch batch, const char* before = "scalar", const char* after = "batch")
+    {
+        const auto a = best(reps, scalar);
+        const auto b = best(reps, batch);
+        std::printf("{\"op\": \"%s\", \"n\": %d, \"lanes\": %d, \"%s_ns\": %.3f, \"%s_ns\": %.3f, \"speedup\": %.2f}\n", op, n, ss::lanes, before, 1e9 * a / n, after, 1e9 * b / n, a / b);
+    }
+
+    // CHEAP SHADERS, SO THE CALL ITSELF IS WHAT IS MEASURED.
+
+    uint32_t checker(const ss::V2 coord, const ss::Uniforms& u)
+    {
+        return (uint32_t(coord.x) ^ uint32_t(coord.y)) & 16 ? 0xFFFFFFFF : uint32_t(u.time);
+    }
+
+    ss::Vu<ss::lanes> checkers(const V2p coord, const ss::Uniforms& u)
+    {
+        return ss::V3p<ss::lanes> { coord.x / u.res.x, coord.y / u.res.y, F { u.time } }.color(1.f);
+    }
+
+    template<typename S>
+    void rows(S shade, int w, int h, const ss::Samples& samples)
+    {
+        auto row = std::vector<uint32_t>(w + ss::lanes);
+        const auto bound = ss::Bound<S> { shade, ss::uniforms() };
+        for(int y = 0; y < h; y++)
+            ss::span(row.data(), bound, 0, w, y, ss::V2 { 1.f }, 0, 1, samples);
+    }
+
+    template<typename Hash>
+    F noise(V2p p, Hash hash)
+    {
+        const auto i = ss::floor(p);
+        const auto f = ss::fract(p);
+        const auto u = f * f * (f * -2.f + 3.f);
+        const auto a = hash(i);
+        const auto b = hash(i + ss::V2 { 1.f, 0.f });
+        const auto c = hash(i + ss::V2 { 0.f, 1.f });
+        const auto d = hash(i + ss::V2 { 1.f, 1.f });
+        return ss::mix(ss::mix(a, b, u.x), ss::mix(c, d, u.x), u.y) * 2.f - 1.f;
+    }
+}
+
+int main()
+{
+    const auto n = ss::option("SS_MICRO_N", 1 << 18);
+    const auto reps = ss::option("SS_MICRO_REPS", 20);
+    const auto m = ss::M3 { 0.8f, 0.6f, 0.f, -0.6f, 0.8f, 0.f, 0.f, 0.f, 1.f };
+    auto x = std::vector<V3>(n);
+    auto y = std::vector<V3>(n);
+    auto w = std::vector<float>(n);
+    auto out = std::vector<V3>(n);
+    auto dots = std::vector<float>(n);
+    auto xs = ss::V3Array { n };
+    auto ys = ss::V3Array { n };
+    auto ws = ss::FArray { n };
+    auto outs = ss::V3Array { n };
+    auto dotss = ss::FArray { n };
+    for(int i = 0; i < n; i++)
+    {
+        x[i] = V3 { std::sin(i * 0.1f), std::cos(i * 0.7f), 0.5f + std::sin(i * 1.3f) };
+        y[i] = V3 { std::cos(i * 0.3f), 0.25f, std::sin(i * 0.9f) };
+        w[i] = 0.5f + 0.5f * std::sin(i * 0.05f);
+        ss::set(xs, i, x[i]);
+        ss::set(ys, i, y[i]);
+        ws[0][i] = w[i];
+    }
+    compare("dot", n, reps, [&] { for(int i = 0; i < n; i++) dots[i] = ss::dot(x[i], y[i]); }, [&] { ss::dot(xs, ys, dotss); });
+    compare("normalize", n, reps, [&] { for(int i = 0; i < n; i++) out[i] = ss::normalize(x[i]); }, [&] { ss::normalize(xs, outs); });
+    compare("reflect", n, reps, [&] { for(int i = 0; i < n; i++) out[i] = ss::reflect(x[i], y[i]); }, [&] { ss::reflect(xs, ys, outs); });
+    compare("mix", n, reps, [&] { for(int i = 0; i < n; i++) out[i] = ss::mix(x[i], y[i], w[i]); }, [&] { ss::mix(xs, ys, ws, outs); });
+    compare("mul", n, reps, [&] { for(int i = 0; i < n; i++) out[i] = ss::mul(x[i], m); }, [&] { ss::mul(xs, m, outs); });
+    compare("m3_times_v3", n, reps, [&] { for(int i = 0; i < n; i++) out[i] = ss::M3 { m } * x[i]; }, [&] { ss::mul(m, xs, outs); });
+    // VALUE NOISE OVER A SEA OF SAMPLE POINTS. THE LIBM AND FAST TIMES ARE THE PROCEDURAL HASH WITH EACH SIN.
+    auto ps = ss::V2Array { n };
+    auto noises = ss::FArray { n };
+    for(int i = 0; i < n; i++)
+        ss::set(ps, i, ss::V2 { i * 0.0173f, std::sin(i * 0.013f) * 40.f });
+    const auto sweep = [&](auto f) {
+        return best(reps, [&] {
+            for(int i = 0; i < ps.padded; i += ss::lanes)
+                noises.store(0, i, f(ss::load(ps, i)));
+        });
+    };
+    const auto libm = sweep([](V2p p) { return noise(p, [](V2p i) { return ss::fract(ss::sin(ss::dot(i, ss::V2 { 127.1f, 311.7f })) * 43758.5453123f); }); });
+    const auto fast = sweep([](V2p p) { return noise(p, [](V2p i) { return ss::fract(ss::fast::sin(ss::dot(i, ss::V2 { 127.1f, 311.7f })) * 43758.5453123f); }); });
+    const auto& hash = ss::hash_texture();
+    const auto& value = ss::noise_texture();
+    const auto lookup = sweep([&](V2p p) { return noise(p, [&](V2p i) { return hash.fetch(i); }); });
+    const auto texture = sweep([&](V2p p) { return value.bilinear(p * float(ss::noise_detail)); });
+    std::printf("{\"op\": \"noise\", \"n\": %d, \"lanes\": %d, \"libm_ns\": %.3f, \"fast_ns\": %.3f, \"hash_texture_ns\": %.3f, \"noise_texture_ns\": %.3f}\n", n, ss::lanes, 1e9 * libm / n, 1e9 * fast / n, 1e9 * lookup / n, 1e9 * texture / n);
+    // THE VOLATILE POINTERS KEEP THE COMPILER FROM TURNING THE INDIRECT CALLS BACK INTO DIRECT ONES.
+    const auto samples = ss::Samples { nullptr };
+    const auto width = 512;
+    const auto height = std::max(1, n / width);
+    auto volatile pixel = &checker;
+    auto volatile pack = &checkers;
+    compare("scalar_shader", width * height, reps, [&] { rows(pixel, width, height, samples); }, [&] { rows(ss::shader<checker>, width, height, samples); }, "indirect", "inlined");
+    compare("packet_shader", width * height, reps, [&] { rows(pack, width, height, samples); }, [&] { rows(ss::shader<checkers>, width, height, samples); }, "indirect", "inlined");
+    // KEEPS THE SCALAR RESULTS LIVE.
+    auto sum = 0.f;
+    for(int i = 0; i < n; i++)
+        sum += dots[i] + out[i].x + dotss[0][i] + outs[0][i] + noises[0][i];
+    std::fprintf(stderr, "checksum: %f\n", double(sum));
+}
@@ -4,9 +4,12 @@
 
 namespace
 {
+    using F = ss::Vf<ss::lanes>;
+    using V2 = ss::V2p<ss::lanes>;
+    using V3 = ss::V3p<ss::lanes>;
+
     const auto NUM_STEPS = 8;
     const auto EPSILON = 1e-3f;
-    const auto EPSILON_NRM = 0.1f / ss::res.x;
     const auto ITER_GEOMETRY = 3;
     const auto ITER_FRAGMENT = 5;
     const auto SEA_HEIGHT = 0.6f;
@@ -17,9 +20,14 @@ namespace
     const auto SEA_WATER_COLOR = ss::V3 { 0.8f, 0.9f, 0.6f } * 0.6f;
     const auto OCTAVE = ss::M2 { 1.6f, 1.2f, -1.2f, 1.6f };
 
-    inline float sea_time()
+    inline float epsilon_nrm(const ss::Uniforms& u)
     {
-        return ss::uptime() * SEA_SPEED;
+        return 0.1f / u.res.x;
+    }
+
+    inline float sea_time(const ss::Uniforms& u)
+    {
+        return u.time * SEA_SPEED;
     }
 
     inline ss::M3 from_euler(ss::V3 ang)
@@ -36,40 +44,51 @@ namespace
         // clang-format on
     }
 
-    inline float hash(ss::V2 p)
+    inline F hash(V2 p)
     {
-        return ss::fract(ss::sin(ss::dot(p, ss::V2 { 127.1, 311.7 })) * 43758.5453123f);
+        return ss::fract(ss::sin(ss::dot(p, ss::V2 { 127.1f, 311.7f })) * 43758.5453123f);
     }
 
-    inline float noise(ss::V2 p)
+    // SS_NOISE=1 READS THE HASH FROM A LOOKUP TEXTURE AND SS_NOISE=2 READS THE WHOLE NOISE FROM ONE. BOTH TILE EVERY
+    // 256 UNITS WHERE THE PROCEDURAL HASH NEVER REPEATS, WHICH IS NOT VISIBLE AT SEA.
+    const auto NOISE = ss::option("SS_NOISE", 0);
+
+    inline F lattice(V2 i)
     {
+        return NOISE == 1 ? ss::hash_texture().fetch(i) : hash(i);
+    }
+
+    inline F noise(V2 p)
+    {
+        if(NOISE == 2)
+            return ss::noise_texture().bilinear(p * float(ss::noise_detail));
         const auto i = ss::floor(p);
         const auto f = ss::fract(p);
         const auto u = f * f * (f * -2.f + 3.f);
         // clang-format off
-        return -1.f + 2.f *
-            ss::mix(ss::mix(hash(i + ss::V2 { 0.f, 0.f }), hash(i + ss::V2 { 1.f, 0.f }), u.x),
-                    ss::mix(hash(i + ss::V2 { 0.f, 1.f }), hash(i + ss::V2 { 1.f, 1.f }), u.x), u.y);
+        return
+            ss::mix(ss::mix(lattice(i + ss::V2 { 0.f, 0.f }), lattice(i + ss::V2 { 1.f, 0.f }), u.x),
+                    ss::mix(lattice(i + ss::V2 { 0.f, 1.f }), lattice(i + ss::V2 { 1.f, 1.f }), u.x), u.y) * 2.f - 1.f;
         // clang-format on
     }
 
-    inline float diffuse(ss::V3 n, ss::V3 l, float p)
+    inline F diffuse(V3 n, V3 l, float p)
     {
         return ss::pow(ss::dot(n, l) * 0.4f + 0.6f, p);
     }
 
-    inline float specular(ss::V3 n, ss::V3 l, ss::V3 e, float s)
+    inline F specular(V3 n, V3 l, V3 e, float s)
     {
         return ss::pow(ss::max(ss::dot(ss::reflect(e, n), l), 0.f), s) * ((s + 8.f) / (ss::PI * 8.f));
     }
 
-    inline ss::V3 sky_color(ss::V3 e)
+    inline V3 sky_color(V3 e)
     {
         e.y = (ss::max(e.y, 0.f) * 0.8f + 0.2f) * 0.8f;
-        return ss::V3(ss::pow(1.f - e.y, 2.f), 1.f - e.y, 0.6f + (1.f - e.y) * 0.4f) * 1.1f;
+        return V3 { ss::pow(1.f - e.y, 2.f), 1.f - e.y, (1.f - e.y) * 0.4f + 0.6f } * 1.1f;
     }
 
-    inline float sea_octave(ss::V2 uv, float choppy)
+    inline F sea_octave(V2 uv, float choppy)
     {
         uv += noise(uv);
         const auto swv = ss::abs(ss::cos(uv));
@@ -78,17 +97,17 @@ namespace
         return ss::pow(1.f - ss::pow(wv.x * wv.y, 0.65f), choppy);
     }
 
-    inline float map(ss::V3 p, const int bound)
+    inline F map(V3 p, const int bound, const ss::Uniforms& u)
     {
         auto freq = SEA_FREQ;
         auto amp = SEA_HEIGHT;
         auto choppy = SEA_CHOPPY;
-        auto uv = ss::V2 { p.x * 0.75f, p.z };
-        auto d = 0.f;
-        auto h = 0.f;
+        auto uv = V2 { p.x * 0.75f, p.z };
+        auto d = F {};
+        auto h = F {};
         for(int i = 0; i < bound; i++)
         {
-            d = sea_octave((uv + sea_time()) * freq, choppy) + sea_octave((uv - sea_time()) * freq, choppy);
+            d = sea_octave((uv + sea_time(u)) * freq, choppy) + sea_octave((uv - sea_time(u)) * freq, choppy);
             h += d * amp;
             uv = ss::mul(uv, OCTAVE);
             freq *= 1.9f;
@@ -98,84 +117,135 @@ namespace
         return p.y - h;
     }
 
-    inline ss::V3 sea_color(ss::V3 p, ss::V3 n, ss::V3 l, ss::V3 eye, ss::V3 dist)
+    inline V3 sea_color(V3 p, V3 n, V3 l, V3 eye, V3 dist)
     {
         auto fresnel = ss::clamp(1.f - ss::dot(n, eye * -1.f), 0.f, 1.f);
         fresnel = ss::pow(fresnel, 3.f) * 0.5f;
         const auto reflected = sky_color(ss::reflect(eye, n));
-        const auto refracted = SEA_BASE + SEA_WATER_COLOR * 0.12f * diffuse(n, l, 80.f);
+        const auto refracted = V3 { SEA_BASE } + V3 { SEA_WATER_COLOR * 0.12f } * diffuse(n, l, 80.f);
         const auto atten = ss::max(1.f - ss::dot(dist, dist) * 0.001f, 0.f);
         auto color = ss::mix(refracted, reflected, fresnel);
-        color += SEA_WATER_COLOR * (p.y - SEA_HEIGHT) * 0.18f * atten;
-        color += ss::V3 { specular(n, l, eye, 60.f) };
+        color += V3 { SEA_WATER_COLOR } * (p.y - SEA_HEIGHT) * 0.18f * atten;
+        color += V3 { specular(n, l, eye, 60.f) };
         return color;
     }
 
-    inline ss::V3 normal(ss::V3 p, float eps)
+    inline V3 normal(V3 p, F eps, const ss::Uniforms& u)
     {
-        const auto y = map(p, ITER_FRAGMENT);
-        return ss::normalize(ss::V3 {
-            map(ss::V3 { p.x + eps, p.y, p.z }, ITER_FRAGMENT) - y,
+        const auto y = map(p, ITER_FRAGMENT, u);
+        return ss::normalize(V3 {
+            map(V3 { p.x + eps, p.y, p.z }, ITER_FRAGMENT, u) - y,
             eps,
-            map(ss::V3 { p.x, p.y, p.z + eps }, ITER_FRAGMENT) - y,
+            map(V3 { p.x, p.y, p.z + eps }, ITER_FRAGMENT, u) - y,
         });
     }
 
-    inline float height_map_tracing(ss::V3 ori, ss::V3 dir, ss::V3& p)
+    inline F height_map_tracing(V3 ori, V3 dir, V3& p, const ss::Uniforms& u)
     {
-        auto tm = 0.f;
-        auto tx = 1000.f;
-        auto hx = map(ori + dir * tx, ITER_GEOMETRY);
-        if(hx > 0.f)
+        // LANES THAT LOOK AT THE SKY EXIT EARLY IN THE SCALAR VERSION. HERE THEY RIDE ALONG UNLESS THE WHOLE
+        // PACKET IS SKY, AND THEIR HIT POINT IS RESET TO MATCH THE SCALAR RESULT AFTERWARDS.
+        auto tm = F { 0.f };
+        auto tx = F { 1000.f };
+        auto hx = map(ori + dir * tx, ITER_GEOMETRY, u);
+        const auto sky = hx > 0.f;
+        if(ss::all(sky))
             return tx;
-        auto hm = map(ori + dir * tm, ITER_GEOMETRY);
-        auto tmid = 0.f;
+        auto hm = map(ori + dir * tm, ITER_GEOMETRY, u);
+        auto tmid = F {};
         for(int i = 0; i < NUM_STEPS; i++)
         {
             tmid = ss::mix(tm, tx, hm / (hm - hx));
             p = ori + dir * tmid;
-            auto hmid = map(p, ITER_GEOMETRY);
-            if(hmid < 0.f)
-            {
-                tx = tmid;
-                hx = hmid;
-            }
-            else
-            {
-                tm = tmid;
-                hm = hmid;
-            }
+            const auto hmid = map(p, ITER_GEOMETRY, u);
+            const auto below = hmid < 0.f;
+            tx = ss::select(below, tmid, tx);
+            hx = ss::select(below, hmid, hx);
+            tm = ss::select(below, tm, tmid);
+            hm = ss::select(below, hm, hmid);
         }
-        return tmid;
+        p = ss::select(sky, V3 {}, p);
+        return ss::select(sky, tx, tmid);
     }
 
-    inline ss::V3 pixel(ss::V2 coord, float time)
+    // DEFERRED IN THREE PASSES OVER THE SEA PIXELS ONLY. RAYS AT OR ABOVE THE HORIZON NEVER SEE THE SEA, SO THE SPLIT
+    // DROPS THEM BEFORE THE MARCH AND THE RESOLVE PAINTS THEM WITH THE SKY ALONE.
+
+    struct GBuffer
     {
-        auto uv = coord / ss::res;
+        ss::V3Array ray;
+        ss::V3Array dir;
+        ss::V3Array p;
+        ss::V3Array n;
+        ss::V3Array sea;
+        GBuffer(int size)
+            : ray { size }
+            , dir { size }
+            , p { size }
+            , n { size }
+            , sea { size }
+        {
+        }
+    };
+
+    inline float frame_time(const ss::Uniforms& u)
+    {
+        return u.time * 0.3f;
+    }
+
+    inline V3 origin(const ss::Uniforms& u)
+    {
+        return V3 { ss::V3 { 0.f, 3.5f, frame_time(u) * 5.f } };
+    }
+
+    void setup(GBuffer& g, const int* index, const V2 coord, const ss::Uniforms& u)
+    {
+        // THE CAMERA SPACE RAY OF A PIXEL ONLY DEPENDS ON THE RESOLUTION, SO ONLY THE ROTATION IS LEFT PER FRAME.
+        auto uv = (V2 { u.res } - coord) / u.res;
         uv = uv * 2.f - 1.f;
-        uv.x *= ss::res.x / ss::res.y;
+        uv.x *= u.res.x / u.res.y;
+        auto ray = ss::normalize(V3 { uv.x, uv.y, -2.f });
+        ray.z += ss::length(uv) * 0.14f;
+        ss::scatter(g.ray, index, ss::normalize(ray));
+    }
+
+    ss::Mf<ss::lanes> rays(GBuffer& g, const int* index, const V2, const ss::Uniforms& u)
+    {
+        const auto time = frame_time(u);
         const auto ang = ss::V3 { ss::sin(time * 3.f) * 0.1f, ss::sin(time) * 0.2f + 0.3f, time };
-        const auto ori = ss::V3 { 0.f, 3.5f, time * 5.f };
-        auto dir = ss::normalize(ss::V3 { uv.x, uv.y, -2.f });
-        dir.z += ss::length(uv) * 0.14f;
-        dir = from_euler(ang) * ss::normalize(dir);
-        auto p = ss::V3 {};
-        height_map_tracing(ori, dir, p);
-        auto dist = p - ori;
-        auto n = normal(p, ss::dot(dist, dist) * EPSILON_NRM);
-        auto light = ss::normalize(ss::V3 { 0.f, 1.f, 0.8f });
-        return ss::mix(sky_color(dir), sea_color(p, n, light, dir, dist), ss::pow(ss::smoothstep(0.f, -0.02f, dir.y), 0.2f));
+        const auto dir = from_euler(ang) * ss::gather(g.ray, index);
+        ss::scatter(g.dir, index, dir);
+        return dir.y < 0.f;
     }
 
-    uint32_t shade(const ss::V2 coord)
+    void trace(GBuffer& g, const int* index, const V2, const ss::Uniforms& u)
     {
-        const auto time = ss::uptime() * 0.3f;
-        const auto v = ss::pow(pixel(ss::res - coord, time), 0.65f);
-        return v.color(1.f);
+        auto p = V3 {};
+        height_map_tracing(origin(u), ss::gather(g.dir, index), p, u);
+        ss::scatter(g.p, index, p);
     }
-}
 
-int main()
-{
-    ss::run(shade);
+    void normals(GBuffer& g, const int* index, const V2, const ss::Uniforms& u)
+    {
+        const auto p = ss::gather(g.p, index);
+        const auto dist = p - origin(u);
+        ss::scatter(g.n, index, normal(p, ss::dot(dist, dist) * epsilon_nrm(u), u));
+    }
+
+    void light(GBuffer& g, const int* index, const V2, const ss::Uniforms& u)
+    {
+        const auto p = ss::gather(g.p, index);
+        const auto light = V3 { ss::normalize(ss::V3 { 0.f, 1.f, 0.8f }) };
+        ss::scatter(g.sea, index, sea_color(p, ss::gather(g.n, index), light, ss::gather(g.dir, index), p - origin(u)));
+    }
+
+    V3 resolve(GBuffer& g, const int* index, const V2, const ss::Uniforms&)
+    {
+        const auto dir = ss::gather(g.dir, index);
+        const auto sky = sky_color(dir);
+        const auto color = ss::select(dir.y < 0.f, ss::mix(sky, ss::gather(g.sea, index), ss::pow(ss::smoothstep(0.f, -0.02f, dir.y), 0.2f)), sky);
+        // THE HEIGHT TERM OF THE SEA COLOR PULLS RED BELOW ZERO IN THE TROUGHS, AND POW OF A NEGATIVE IS NAN.
+        return ss::pow(ss::clamp(color, 0.f, 1.f), 0.65f);
+    }
+
+    const auto enrolled = ss::enroll("seascape", ss::Deferred<GBuffer, V3> { setup, rays, { trace, normals, light }, resolve });
 }
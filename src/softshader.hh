@@ -2,6 +2,24 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// SHADERS, OR WHOLE BUILDS WITH -DSS_FAST_MATH, OPT INTO THE FAST MATH TIER. -DSS_EXACT_MATH FORCES LIBM REGARDLESS.
+#ifdef SS_EXACT_MATH
+#undef SS_FAST_MATH
+#endif
+
+#ifdef SS_FAST_MATH
+#define SS_TIER fast_tier
+#else
+#define SS_TIER exact_tier
+#endif
 
 namespace ss
 {
@@ -29,6 +47,11 @@ namespace ss
         return a > b ? a : b;
     }
 
+    inline float select(bool m, float a, float b)
+    {
+        return m ? a : b;
+    }
+
     struct V2
     {
         float x {};
@@ -128,7 +151,7 @@ namespace ss
         }
         float& operator[](int i)
         {
-            return reinterpret_cast<float*>(this)[i];
+            return i == 0 ? x : y;
         }
     };
 
@@ -151,7 +174,7 @@ namespace ss
         }
         V2& operator[](int i)
         {
-            return reinterpret_cast<V2*>(this)[i];
+            return i == 0 ? x : y;
         }
     };
 
@@ -281,7 +304,7 @@ namespace ss
         }
         float& operator[](int i)
         {
-            return reinterpret_cast<float*>(this)[i];
+            return i == 0 ? x : i == 1 ? y : z;
         }
         uint32_t color(float a) const
         {
@@ -322,40 +345,68 @@ namespace ss
         }
         V3& operator[](int i)
         {
-            return reinterpret_cast<V3*>(this)[i];
+            return i == 0 ? x : i == 1 ? y : z;
         }
     };
 
     constexpr auto PI = std::acos(-1.0f);
 
-    inline float sin(float a)
+    namespace fast
     {
-        return std::sin(a);
-    }
+        template<typename T>
+        T sin(T x);
 
-    inline V2 sin(V2 v)
-    {
-        return V2 { std::sin(v.x), std::sin(v.y) };
-    }
+        template<typename T>
+        T cos(T x);
 
-    inline V3 sin(V3 v)
-    {
-        return V3 { std::sin(v.x), std::sin(v.y), std::sin(v.z) };
-    }
+        template<typename T>
+        T atan2(T y, T x);
 
-    inline float cos(float a)
-    {
-        return std::cos(a);
+        template<typename T>
+        T pow(T x, float n);
     }
 
-    inline V2 cos(V2 v)
+    // EVERYTHING THE MATH TIER CHANGES LIVES IN AN INLINE NAMESPACE NAMED AFTER THE TIER, SO SHADERS BUILT WITH AND
+    // WITHOUT SS_FAST_MATH CAN LINK INTO ONE EXECUTABLE WITHOUT ONE TIER SILENTLY REPLACING THE OTHER.
+    inline namespace SS_TIER
     {
-        return V2 { std::cos(v.x), std::cos(v.y) };
-    }
+        inline float sin(float a)
+        {
+#ifdef SS_FAST_MATH
+            return fast::sin(a);
+#else
+            return std::sin(a);
+#endif
+        }
 
-    inline V3 cos(V3 v)
-    {
-        return V3 { std::cos(v.x), std::cos(v.y), std::cos(v.z) };
+        inline V2 sin(V2 v)
+        {
+            return V2 { sin(v.x), sin(v.y) };
+        }
+
+        inline V3 sin(V3 v)
+        {
+            return V3 { sin(v.x), sin(v.y), sin(v.z) };
+        }
+
+        inline float cos(float a)
+        {
+#ifdef SS_FAST_MATH
+            return fast::cos(a);
+#else
+            return std::cos(a);
+#endif
+        }
+
+        inline V2 cos(V2 v)
+        {
+            return V2 { cos(v.x), cos(v.y) };
+        }
+
+        inline V3 cos(V3 v)
+        {
+            return V3 { cos(v.x), cos(v.y), cos(v.z) };
+        }
     }
 
     inline float length(float f)
@@ -398,24 +449,35 @@ namespace ss
         return V3 { mod(v.x, f), mod(v.y, f), mod(v.z, f) };
     }
 
-    inline float atan2(float y, float x)
+    inline namespace SS_TIER
     {
-        return std::atan2(y, x);
-    }
+        inline float atan2(float y, float x)
+        {
+#ifdef SS_FAST_MATH
+            return fast::atan2(y, x);
+#else
+            return std::atan2(y, x);
+#endif
+        }
 
-    inline float pow(float x, float n)
-    {
-        return std::pow(x, n);
-    }
+        inline float pow(float x, float n)
+        {
+#ifdef SS_FAST_MATH
+            return fast::pow(x, n);
+#else
+            return std::pow(x, n);
+#endif
+        }
 
-    inline V2 pow(V2 v, float n)
-    {
-        return V2 { std::pow(v.x, n), std::pow(v.y, n) };
-    }
+        inline V2 pow(V2 v, float n)
+        {
+            return V2 { pow(v.x, n), pow(v.y, n) };
+        }
 
-    inline V3 pow(V3 v, float n)
-    {
-        return V3 { std::pow(v.x, n), std::pow(v.y, n), std::pow(v.z, n) };
+        inline V3 pow(V3 v, float n)
+        {
+            return V3 { pow(v.x, n), pow(v.y, n), pow(v.z, n) };
+        }
     }
 
     inline float dot(V2 x, V2 y)
@@ -509,177 +571,4788 @@ namespace ss
             v.x * m.z.x + v.y * m.z.y + v.z * m.z.z,
         };
     }
-}
 
-// HEADERS INCLUDES ARE SPLIT TO NOT POLLUTE SOFTSHADER MATH LIBRARY WITH OLD CSTYLE DECLARATIONS.
+    // PACKETS SHADE A RUN OF N PIXELS AT ONCE WITH GCC VECTOR EXTENSIONS. THE LANE COUNT FOLLOWS
+    // THE WIDEST INSTRUCTION SET ENABLED AT COMPILE TIME: AVX-512, AVX/AVX2, OTHERWISE SSE.
 
-#include <vector>
-#include <chrono>
-#include <thread>
-#include <cstdio>
-#include <SDL2/SDL.h>
+#if defined(__AVX512F__)
+    constexpr auto lanes = 16;
+#elif defined(__AVX__)
+    constexpr auto lanes = 8;
+#else
+    constexpr auto lanes = 4;
+#endif
 
-namespace ss
-{
-    const auto xres = 768;
-    const auto yres = 432;
+    template<typename T>
+    struct Identity
+    {
+        using type = T;
+    };
 
-    const auto res = V2 { float { xres }, float { yres } };
+    // ONLY THE FIRST PACKET ARGUMENT DEDUCES N. THE REST ACCEPT ANYTHING THAT BROADCASTS, LIKE FLOATS.
+    template<typename T>
+    using Broadcast = typename Identity<T>::type;
 
-    auto time = 0.f;
+    // GCC DROPS VECTOR ATTRIBUTES ON TEMPLATE DEPENDENT ALIASES, SO EACH REGISTER WIDTH IS SPELLED OUT.
+    template<int N>
+    struct Register;
 
-    inline float uptime()
+    template<>
+    struct Register<4>
     {
-        return time;
-    }
-
-    using Shade = uint32_t (*)(const V2);
+        typedef float F __attribute__((vector_size(16)));
+        typedef int32_t I __attribute__((vector_size(16)));
+        typedef uint32_t U __attribute__((vector_size(16)));
+        typedef double D __attribute__((vector_size(32)));
+    };
 
-    inline void tick()
+    template<>
+    struct Register<8>
     {
-        time = SDL_GetTicks() * 0.001f;
-    }
+        typedef float F __attribute__((vector_size(32)));
+        typedef int32_t I __attribute__((vector_size(32)));
+        typedef uint32_t U __attribute__((vector_size(32)));
+        typedef double D __attribute__((vector_size(64)));
+    };
 
-    class Video
+    template<>
+    struct Register<16>
     {
-        SDL_Window* window {};
-        SDL_Renderer* renderer {};
+        typedef float F __attribute__((vector_size(64)));
+        typedef int32_t I __attribute__((vector_size(64)));
+        typedef uint32_t U __attribute__((vector_size(64)));
+        typedef double D __attribute__((vector_size(128)));
+    };
 
-    public:
-        SDL_Texture* texture {};
-        Video()
+    template<int N>
+    using Vu = typename Register<N>::U;
+
+    template<int N>
+    struct Mf
+    {
+        using Raw = typename Register<N>::I;
+        Raw v {};
+        Mf()
         {
-            window = SDL_CreateWindow("SOFTSHADER", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, xres, yres, SDL_WINDOW_SHOWN);
-            renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, xres, yres);
         }
-
-        void render()
+        Mf(Raw v)
+            : v { v }
         {
-            SDL_RenderCopy(renderer, texture, NULL, NULL);
-            SDL_RenderPresent(renderer);
         }
-
-        ~Video()
+        friend Mf operator&(Mf a, Mf b)
         {
-            SDL_DestroyWindow(window);
-            SDL_DestroyRenderer(renderer);
-            SDL_DestroyTexture(texture);
-            SDL_Quit();
+            return Mf { a.v & b.v };
+        }
+        friend Mf operator|(Mf a, Mf b)
+        {
+            return Mf { a.v | b.v };
+        }
+        friend Mf operator!(Mf a)
+        {
+            return Mf { ~a.v };
         }
     };
 
-    class Vram
+    template<int N>
+    struct Vf
     {
-        uint32_t* pixels {};
-        SDL_Texture* texture {};
-
-    public:
-        std::vector<int> slices {};
-        const int cpus {};
-        Vram()
-            : cpus { SDL_GetCPUCount() }
+        using Raw = typename Register<N>::F;
+        Raw v {};
+        Vf()
         {
-            const auto width = yres / cpus;
-            for(int i = 0; i < cpus + 1; i++)
-                slices.push_back(i * width);
         }
-
-        void put(int x, int y, uint32_t color)
+        Vf(float f)
+            : v { Raw {} + f }
         {
-            pixels[x + y * xres] = color;
         }
-
-        void lock(SDL_Texture* texture)
+        Vf(Raw v)
+            : v { v }
         {
-            void* raw;
-            int pitch;
-            SDL_LockTexture(texture, NULL, &raw, &pitch);
-            pixels = (uint32_t*)raw;
-            this->texture = texture;
         }
-
-        void unlock()
+        static Vf ramp()
         {
-            SDL_UnlockTexture(texture);
+            auto r = Vf {};
+            for(int i = 0; i < N; i++)
+                r[i] = float(i);
+            return r;
         }
-    };
-
-    class Input
-    {
-        const uint8_t* key {};
-
-    public:
-        bool done { false };
-        Input()
-            : key { SDL_GetKeyboardState(NULL) }
+        friend Vf operator+(Vf a, Vf b)
         {
+            return Vf { a.v + b.v };
         }
-        void update()
+        friend Vf operator-(Vf a, Vf b)
         {
-            SDL_Event event;
-            SDL_PollEvent(&event);
-            if(key[SDL_SCANCODE_END] || key[SDL_SCANCODE_ESCAPE] || event.type == SDL_QUIT)
-                done = true;
+            return Vf { a.v - b.v };
+        }
+        friend Vf operator*(Vf a, Vf b)
+        {
+            return Vf { a.v * b.v };
+        }
+        friend Vf operator/(Vf a, Vf b)
+        {
+            return Vf { a.v / b.v };
+        }
+        friend Vf operator-(Vf a)
+        {
+            return Vf { -a.v };
+        }
+        friend Mf<N> operator<(Vf a, Vf b)
+        {
+            return Mf<N> { a.v < b.v };
+        }
+        friend Mf<N> operator>(Vf a, Vf b)
+        {
+            return Mf<N> { a.v > b.v };
+        }
+        friend Mf<N> operator<=(Vf a, Vf b)
+        {
+            return Mf<N> { a.v <= b.v };
+        }
+        friend Mf<N> operator>=(Vf a, Vf b)
+        {
+            return Mf<N> { a.v >= b.v };
+        }
+        friend Mf<N> operator==(Vf a, Vf b)
+        {
+            return Mf<N> { a.v == b.v };
+        }
+        Vf& operator+=(Vf f)
+        {
+            v += f.v;
+            return *this;
+        }
+        Vf& operator-=(Vf f)
+        {
+            v -= f.v;
+            return *this;
+        }
+        Vf& operator*=(Vf f)
+        {
+            v *= f.v;
+            return *this;
+        }
+        Vf& operator/=(Vf f)
+        {
+            v /= f.v;
+            return *this;
+        }
+        float& operator[](int i)
+        {
+            return reinterpret_cast<float*>(&v)[i];
         }
     };
 
-    struct Needle
+    template<int N>
+    struct V2p
     {
-        Vram& vram;
-        const Shade shade {};
-        const int y0 {};
-        const int y1 {};
-        Needle(Vram& vram, Shade shade, int y0, int y1)
-            : vram { vram }
-            , shade { shade }
-            , y0 { y0 }
-            , y1 { y1 }
+        Vf<N> x {};
+        Vf<N> y {};
+        V2p()
         {
         }
-        void operator()()
+        V2p(Vf<N> x, Vf<N> y)
+            : x { x }
+            , y { y }
         {
-            for(int y = y0; y < y1; y++)
-                for(int x = 0; x < xres; x++)
-                {
-                    const auto coord = V2 { float(x), float(y) };
-                    vram.put(x, y, shade(coord));
-                }
+        }
+        V2p(Vf<N> xy)
+            : x { xy }
+            , y { xy }
+        {
+        }
+        V2p(V2 v)
+            : x { v.x }
+            , y { v.y }
+        {
+        }
+        friend V2p operator+(V2p a, V2p b)
+        {
+            return V2p { a.x + b.x, a.y + b.y };
+        }
+        friend V2p operator-(V2p a, V2p b)
+        {
+            return V2p { a.x - b.x, a.y - b.y };
+        }
+        friend V2p operator*(V2p a, V2p b)
+        {
+            return V2p { a.x * b.x, a.y * b.y };
+        }
+        friend V2p operator/(V2p a, V2p b)
+        {
+            return V2p { a.x / b.x, a.y / b.y };
+        }
+        friend V2p operator+(V2p a, Vf<N> f)
+        {
+            return V2p { a.x + f, a.y + f };
+        }
+        friend V2p operator-(V2p a, Vf<N> f)
+        {
+            return V2p { a.x - f, a.y - f };
+        }
+        friend V2p operator*(V2p a, Vf<N> f)
+        {
+            return V2p { a.x * f, a.y * f };
+        }
+        friend V2p operator/(V2p a, Vf<N> f)
+        {
+            return V2p { a.x / f, a.y / f };
+        }
+        V2p& operator+=(V2p v)
+        {
+            x += v.x;
+            y += v.y;
+            return *this;
+        }
+        V2p& operator-=(V2p v)
+        {
+            x -= v.x;
+            y -= v.y;
+            return *this;
+        }
+        V2p& operator*=(V2p v)
+        {
+            x *= v.x;
+            y *= v.y;
+            return *this;
+        }
+        V2p& operator/=(V2p v)
+        {
+            x /= v.x;
+            y /= v.y;
+            return *this;
+        }
+        Vf<N>& operator[](int i)
+        {
+            return i == 0 ? x : y;
         }
     };
 
-    void draw(Vram& vram, Shade shade)
+    template<int N>
+    struct V3p
     {
-        auto threads = std::vector<std::thread>();
-        for(int i = 0; i < vram.cpus; i++)
+        Vf<N> x {};
+        Vf<N> y {};
+        Vf<N> z {};
+        V3p()
         {
-            const auto needle = Needle {
-                vram,
-                shade,
-                vram.slices[i + 0], // MULTITHREADS RENDER WITH HORIZONTAL SLICES.
-                vram.slices[i + 1],
-            };
-            threads.push_back(std::thread { needle });
         }
-        for(auto& thread : threads)
-            thread.join();
-    }
-
-    void run(Shade shade)
-    {
-        auto video = Video {};
-        auto vram = Vram {};
-        for(auto input = Input {}; !input.done; input.update())
+        V3p(Vf<N> xyz)
+            : x { xyz }
+            , y { xyz }
+            , z { xyz }
         {
-            tick();
-            vram.lock(video.texture);
-            const auto t0 = std::chrono::high_resolution_clock::now();
-            draw(vram, shade);
-            const auto t1 = std::chrono::high_resolution_clock::now();
-            vram.unlock();
-            video.render();
-            std::chrono::duration<double> dt = std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0);
-            std::printf("draw fps: %f\n", 1.0 / dt.count());
         }
+        V3p(Vf<N> x, Vf<N> y, Vf<N> z)
+            : x { x }
+            , y { y }
+            , z { z }
+        {
+        }
+        V3p(V3 v)
+            : x { v.x }
+            , y { v.y }
+            , z { v.z }
+        {
+        }
+        friend V3p operator+(V3p a, V3p b)
+        {
+            return V3p { a.x + b.x, a.y + b.y, a.z + b.z };
+        }
+        friend V3p operator-(V3p a, V3p b)
+        {
+            return V3p { a.x - b.x, a.y - b.y, a.z - b.z };
+        }
+        friend V3p operator*(V3p a, V3p b)
+        {
+            return V3p { a.x * b.x, a.y * b.y, a.z * b.z };
+        }
+        friend V3p operator/(V3p a, V3p b)
+        {
+            return V3p { a.x / b.x, a.y / b.y, a.z / b.z };
+        }
+        friend V3p operator+(V3p a, Vf<N> f)
+        {
+            return V3p { a.x + f, a.y + f, a.z + f };
+        }
+        friend V3p operator-(V3p a, Vf<N> f)
+        {
+            return V3p { a.x - f, a.y - f, a.z - f };
+        }
+        friend V3p operator*(V3p a, Vf<N> f)
+        {
+            return V3p { a.x * f, a.y * f, a.z * f };
+        }
+        friend V3p operator/(V3p a, Vf<N> f)
+        {
+            return V3p { a.x / f, a.y / f, a.z / f };
+        }
+        V3p& operator+=(V3p v)
+        {
+            x += v.x;
+            y += v.y;
+            z += v.z;
+            return *this;
+        }
+        V3p& operator-=(V3p v)
+        {
+            x -= v.x;
+            y -= v.y;
+            z -= v.z;
+            return *this;
+        }
+        V3p& operator*=(V3p v)
+        {
+            x *= v.x;
+            y *= v.y;
+            z *= v.z;
+            return *this;
+        }
+        V3p& operator/=(V3p v)
+        {
+            x /= v.x;
+            y /= v.y;
+            z /= v.z;
+            return *this;
+        }
+        Vf<N>& operator[](int i)
+        {
+            return i == 0 ? x : i == 1 ? y : z;
+        }
+        Vu<N> color(Vf<N> a) const
+        {
+            return channel(a) << 24 | channel(x) << 16 | channel(y) << 8 | channel(z) << 0;
+        }
+
+    private:
+        static Vu<N> channel(Vf<N> c)
+        {
+            // SIGNED CONVERSION AND A BYTE MASK MIRROR THE SCALAR UINT8_T CAST, SO NAN LANES CANNOT BLEED INTO OTHER CHANNELS.
+            const auto i = __builtin_convertvector(clamp(c, 0.f, 1.f).v * 255.f, typename Mf<N>::Raw);
+            return __builtin_convertvector(i & 0xFF, Vu<N>);
+        }
+    };
+
+    template<int N>
+    inline Vf<N> select(Mf<N> m, Broadcast<Vf<N>> a, Broadcast<Vf<N>> b)
+    {
+        return Vf<N> { m.v ? a.v : b.v };
+    }
+
+    template<int N>
+    inline V2p<N> select(Mf<N> m, Broadcast<V2p<N>> a, Broadcast<V2p<N>> b)
+    {
+        return V2p<N> { select(m, a.x, b.x), select(m, a.y, b.y) };
+    }
+
+    template<int N>
+    inline V3p<N> select(Mf<N> m, Broadcast<V3p<N>> a, Broadcast<V3p<N>> b)
+    {
+        return V3p<N> { select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z) };
+    }
+
+    template<int N>
+    inline bool any(Mf<N> m)
+    {
+        auto r = 0;
+        for(int i = 0; i < N; i++)
+            r |= m.v[i];
+        return r != 0;
+    }
+
+    template<int N>
+    inline bool all(Mf<N> m)
+    {
+        auto r = -1;
+        for(int i = 0; i < N; i++)
+            r &= m.v[i];
+        return r != 0;
+    }
+
+    template<int N, typename F>
+    inline Vf<N> lanewise(Vf<N> a, F f)
+    {
+        for(int i = 0; i < N; i++)
+            a[i] = f(a[i]);
+        return a;
+    }
+
+    template<int N>
+    inline Vf<N> abs(Vf<N> a)
+    {
+        return Vf<N> { a.v < 0.f ? -a.v : a.v };
+    }
+
+    template<int N>
+    inline V2p<N> abs(V2p<N> v)
+    {
+        return V2p<N> { abs(v.x), abs(v.y) };
+    }
+
+    template<int N>
+    inline V3p<N> abs(V3p<N> v)
+    {
+        return V3p<N> { abs(v.x), abs(v.y), abs(v.z) };
+    }
+
+    template<int N>
+    inline Vf<N> max(Vf<N> a, Broadcast<Vf<N>> b)
+    {
+        return Vf<N> { a.v > b.v ? a.v : b.v };
+    }
+
+    template<int N>
+    inline Vf<N> min(Vf<N> a, Broadcast<Vf<N>> b)
+    {
+        return Vf<N> { a.v < b.v ? a.v : b.v };
+    }
+
+    template<int N>
+    inline Vf<N> clamp(Vf<N> v, float lo, float hi)
+    {
+        v = (v + lo + abs(v - lo)) * 0.5f;
+        v = (v + hi - abs(v - hi)) * 0.5f;
+        return v;
+    }
+
+    template<int N>
+    inline Vf<N> smoothstep(float edge0, float edge1, Vf<N> x)
+    {
+        const auto t = clamp((x - edge0) / (edge1 - edge0), 0.f, 1.f);
+        return t * t * (3.f - t * 2.f);
+    }
+
+    inline namespace SS_TIER
+    {
+        template<int N>
+        inline Vf<N> sin(Vf<N> a)
+        {
+#ifdef SS_FAST_MATH
+            return fast::sin(a);
+#else
+            return lanewise(a, [](float f) { return std::sin(f); });
+#endif
+        }
+
+        template<int N>
+        inline V2p<N> sin(V2p<N> v)
+        {
+            return V2p<N> { sin(v.x), sin(v.y) };
+        }
+
+        template<int N>
+        inline V3p<N> sin(V3p<N> v)
+        {
+            return V3p<N> { sin(v.x), sin(v.y), sin(v.z) };
+        }
+
+        template<int N>
+        inline Vf<N> cos(Vf<N> a)
+        {
+#ifdef SS_FAST_MATH
+            return fast::cos(a);
+#else
+            return lanewise(a, [](float f) { return std::cos(f); });
+#endif
+        }
+
+        template<int N>
+        inline V2p<N> cos(V2p<N> v)
+        {
+            return V2p<N> { cos(v.x), cos(v.y) };
+        }
+
+        template<int N>
+        inline V3p<N> cos(V3p<N> v)
+        {
+            return V3p<N> { cos(v.x), cos(v.y), cos(v.z) };
+        }
+    }
+
+    template<int N>
+    inline Vf<N> sqrt(Vf<N> a)
+    {
+        return lanewise(a, [](float f) { return std::sqrt(f); });
+    }
+
+    template<int N>
+    inline Vf<N> length(V2p<N> v)
+    {
+        return sqrt(v.x * v.x + v.y * v.y);
+    }
+
+    template<int N>
+    inline Vf<N> length(V3p<N> v)
+    {
+        return sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    }
+
+    template<int N>
+    inline Vf<N> floor(Vf<N> a)
+    {
+        // ONE ROUND INSTRUCTION WITH SSE4.1 OR AVX, AND UNLIKE AN INT32 ROUND TRIP IT HOLDS FOR ANY MAGNITUDE AND NAN.
+        return lanewise(a, [](float f) { return std::floor(f); });
+    }
+
+    template<int N>
+    inline V2p<N> floor(V2p<N> v)
+    {
+        return V2p<N> { floor(v.x), floor(v.y) };
+    }
+
+    template<int N>
+    inline Vf<N> fract(Vf<N> a)
+    {
+        return a - floor(a);
+    }
+
+    template<int N>
+    inline V2p<N> fract(V2p<N> v)
+    {
+        return V2p<N> { fract(v.x), fract(v.y) };
+    }
+
+    template<int N>
+    inline Vf<N> mod(Vf<N> x, Broadcast<Vf<N>> y)
+    {
+        return x - y * floor(x / y);
+    }
+
+    template<int N>
+    inline V2p<N> mod(V2p<N> v, float f)
+    {
+        return V2p<N> { mod(v.x, f), mod(v.y, f) };
+    }
+
+    template<int N>
+    inline V3p<N> mod(V3p<N> v, float f)
+    {
+        return V3p<N> { mod(v.x, f), mod(v.y, f), mod(v.z, f) };
+    }
+
+    template<int N>
+    inline V3p<N> clamp(V3p<N> v, float lo, float hi)
+    {
+        return V3p<N> { clamp(v.x, lo, hi), clamp(v.y, lo, hi), clamp(v.z, lo, hi) };
+    }
+
+    inline namespace SS_TIER
+    {
+        template<int N>
+        inline Vf<N> atan2(Vf<N> y, Vf<N> x)
+        {
+#ifdef SS_FAST_MATH
+            return fast::atan2(y, x);
+#else
+            for(int i = 0; i < N; i++)
+                y[i] = std::atan2(y[i], x[i]);
+            return y;
+#endif
+        }
+
+        template<int N>
+        inline Vf<N> pow(Vf<N> x, float n)
+        {
+#ifdef SS_FAST_MATH
+            return fast::pow(x, n);
+#else
+            return lanewise(x, [n](float f) { return std::pow(f, n); });
+#endif
+        }
+
+        template<int N>
+        inline V2p<N> pow(V2p<N> v, float n)
+        {
+            return V2p<N> { pow(v.x, n), pow(v.y, n) };
+        }
+
+        template<int N>
+        inline V3p<N> pow(V3p<N> v, float n)
+        {
+            return V3p<N> { pow(v.x, n), pow(v.y, n), pow(v.z, n) };
+        }
+    }
+
+    template<int N>
+    inline Vf<N> dot(V2p<N> x, Broadcast<V2p<N>> y)
+    {
+        return x.x * y.x + x.y * y.y;
+    }
+
+    template<int N>
+    inline Vf<N> dot(V3p<N> x, Broadcast<V3p<N>> y)
+    {
+        return x.x * y.x + x.y * y.y + x.z * y.z;
+    }
+
+    template<int N>
+    inline Vf<N> mix(Vf<N> x, Broadcast<Vf<N>> y, Broadcast<Vf<N>> a)
+    {
+        return x * (1.f - a) + y * a;
+    }
+
+    template<int N>
+    inline V2p<N> mix(V2p<N> x, Broadcast<V2p<N>> y, Broadcast<Vf<N>> a)
+    {
+        return V2p<N> { mix(x.x, y.x, a), mix(x.y, y.y, a) };
+    }
+
+    template<int N>
+    inline V2p<N> mix(V2p<N> x, Broadcast<V2p<N>> y, V2p<N> a)
+    {
+        return V2p<N> { mix(x.x, y.x, a.x), mix(x.y, y.y, a.y) };
+    }
+
+    template<int N>
+    inline V3p<N> mix(V3p<N> x, Broadcast<V3p<N>> y, Broadcast<Vf<N>> a)
+    {
+        return V3p<N> { mix(x.x, y.x, a), mix(x.y, y.y, a), mix(x.z, y.z, a) };
+    }
+
+    template<int N>
+    inline V3p<N> mix(V3p<N> x, Broadcast<V3p<N>> y, V3p<N> a)
+    {
+        return V3p<N> { mix(x.x, y.x, a.x), mix(x.y, y.y, a.y), mix(x.z, y.z, a.z) };
+    }
+
+    template<int N>
+    inline V2p<N> reflect(V2p<N> i, V2p<N> n)
+    {
+        return i - n * dot(n, i) * 2.f;
+    }
+
+    template<int N>
+    inline V3p<N> reflect(V3p<N> i, V3p<N> n)
+    {
+        return i - n * dot(n, i) * 2.f;
+    }
+
+    template<int N>
+    inline V2p<N> normalize(V2p<N> v)
+    {
+        return v / length(v);
+    }
+
+    template<int N>
+    inline V3p<N> normalize(V3p<N> v)
+    {
+        return v / length(v);
+    }
+
+    template<int N>
+    inline V2p<N> mul(V2p<N> v, M2 m)
+    {
+        return V2p<N> {
+            v.x * m.x.x + v.y * m.x.y,
+            v.x * m.y.x + v.y * m.y.y,
+        };
+    }
+
+    template<int N>
+    inline V3p<N> mul(V3p<N> v, M3 m)
+    {
+        return V3p<N> {
+            v.x * m.x.x + v.y * m.x.y + v.z * m.x.z,
+            v.x * m.y.x + v.y * m.y.y + v.z * m.y.z,
+            v.x * m.z.x + v.y * m.z.y + v.z * m.z.z,
+        };
+    }
+
+    template<int N>
+    inline V3p<N> operator*(M3 m, V3p<N> v)
+    {
+        return V3p<N> {
+            v.x * m.x.x + v.y * m.x.y + v.z * m.x.z,
+            v.x * m.y.x + v.y * m.y.y + v.z * m.y.z,
+            v.x * m.z.x + v.y * m.z.y + v.z * m.z.z,
+        };
+    }
+
+    // STRUCTURE OF ARRAYS FOR WHOLE FRAME INTERMEDIATES. EACH OF THE K COMPONENTS IS ITS OWN CACHE LINE ALIGNED RUN
+    // OF FLOATS, ZERO PADDED TO A MULTIPLE OF 16 SO BATCH OPERATIONS MOVE WHOLE PACKETS WITH NO SCALAR TAIL. THE
+    // PADDING IS SCRATCH: BATCH OPERATIONS WRITE IT TOO, SO IT MAY HOLD NAN AFTER, EG. A NORMALIZE.
+
+    template<int K>
+    class Array
+    {
+        float* data {};
+
+    public:
+        const int size {};
+        const int padded {};
+        Array(int size)
+            : size { size }
+            , padded { (size + 15) / 16 * 16 }
+        {
+            data = static_cast<float*>(std::aligned_alloc(64, sizeof(*data) * K * padded));
+            std::fill(data, data + K * padded, 0.f);
+        }
+
+        Array(const Array&) = delete;
+        Array& operator=(const Array&) = delete;
+
+        ~Array()
+        {
+            std::free(data);
+        }
+
+        float* operator[](int k)
+        {
+            return data + k * padded;
+        }
+
+        const float* operator[](int k) const
+        {
+            return data + k * padded;
+        }
+
+        Vf<lanes> load(int k, int i) const
+        {
+            auto f = Vf<lanes> {};
+            std::memcpy(&f.v, data + k * padded + i, sizeof(f.v));
+            return f;
+        }
+
+        void store(int k, int i, Vf<lanes> f)
+        {
+            std::memcpy(data + k * padded + i, &f.v, sizeof(f.v));
+        }
+    };
+
+    using FArray = Array<1>;
+    using V2Array = Array<2>;
+    using V3Array = Array<3>;
+
+    inline V3 get(const V3Array& a, int i)
+    {
+        return V3 { a[0][i], a[1][i], a[2][i] };
+    }
+
+    inline void set(V3Array& a, int i, V3 v)
+    {
+        a[0][i] = v.x;
+        a[1][i] = v.y;
+        a[2][i] = v.z;
+    }
+
+    inline V2 get(const V2Array& a, int i)
+    {
+        return V2 { a[0][i], a[1][i] };
+    }
+
+    inline void set(V2Array& a, int i, V2 v)
+    {
+        a[0][i] = v.x;
+        a[1][i] = v.y;
+    }
+
+    inline V3p<lanes> load(const V3Array& a, int i)
+    {
+        return V3p<lanes> { a.load(0, i), a.load(1, i), a.load(2, i) };
+    }
+
+    inline void store(V3Array& a, int i, V3p<lanes> v)
+    {
+        a.store(0, i, v.x);
+        a.store(1, i, v.y);
+        a.store(2, i, v.z);
+    }
+
+    inline V2p<lanes> load(const V2Array& a, int i)
+    {
+        return V2p<lanes> { a.load(0, i), a.load(1, i) };
+    }
+
+    inline void store(V2Array& a, int i, V2p<lanes> v)
+    {
+        a.store(0, i, v.x);
+        a.store(1, i, v.y);
+    }
+
+    // INDEXED ACCESS FOR PACKETS OF SCATTERED PIXELS, EG. THE COMPACTED LISTS OF A DEFERRED SHADER. RUNS OF CONSECUTIVE
+    // INDICES, WHICH IS EVERY FULL ROW PACKET, TAKE A PLAIN VECTOR LOAD OR STORE.
+
+    inline bool consecutive(const int* index)
+    {
+        auto run = true;
+        for(int i = 1; i < lanes; i++)
+            run &= index[i] == index[0] + i;
+        return run;
+    }
+
+    inline Vf<lanes> gather(const FArray& a, const int* index)
+    {
+        if(consecutive(index))
+            return a.load(0, index[0]);
+        auto f = Vf<lanes> {};
+        for(int i = 0; i < lanes; i++)
+            f.v[i] = a[0][index[i]];
+        return f;
+    }
+
+    inline void scatter(FArray& a, const int* index, Vf<lanes> f)
+    {
+        if(consecutive(index))
+        {
+            a.store(0, index[0], f);
+            return;
+        }
+        for(int i = 0; i < lanes; i++)
+            a[0][index[i]] = f.v[i];
+    }
+
+    inline V3p<lanes> gather(const V3Array& a, const int* index)
+    {
+        if(consecutive(index))
+            return load(a, index[0]);
+        auto v = V3p<lanes> {};
+        for(int i = 0; i < lanes; i++)
+        {
+            v.x.v[i] = a[0][index[i]];
+            v.y.v[i] = a[1][index[i]];
+            v.z.v[i] = a[2][index[i]];
+        }
+        return v;
+    }
+
+    inline void scatter(V3Array& a, const int* index, V3p<lanes> v)
+    {
+        if(consecutive(index))
+        {
+            store(a, index[0], v);
+            return;
+        }
+        for(int i = 0; i < lanes; i++)
+        {
+            a[0][index[i]] = v.x.v[i];
+            a[1][index[i]] = v.y.v[i];
+            a[2][index[i]] = v.z.v[i];
+        }
+    }
+
+    // COLOR PACKING TURNS ROWS OF FLOAT RGB INTO OPAQUE PIXELS A PACKET AT A TIME. FORMATS ARE NAMED BY THEIR BYTES IN MEMORY:
+    //
+    //     bgra      8 BITS A CHANNEL, THE FRAMEBUFFER'S OWN LAYOUT, IE. ARGB8888 WORDS ON LITTLE ENDIAN
+    //     argb      8 BITS A CHANNEL, ALPHA FIRST, IE. ARGB8888 WORDS ON BIG ENDIAN
+    //     rgb565    16 BIT LITTLE ENDIAN WORDS OF 5 BITS RED, 6 GREEN AND 5 BLUE
+    //     rgb10     32 BIT LITTLE ENDIAN WORDS OF 2 BITS ALPHA ABOVE 10 BITS EACH OF RED, GREEN AND BLUE, IE. ARGB2101010
+
+    enum class Format
+    {
+        bgra,
+        argb,
+        rgb565,
+        rgb10,
+    };
+
+    inline int bytes(Format format)
+    {
+        return format == Format::rgb565 ? 2 : 4;
+    }
+
+    template<int N>
+    inline Vu<N> quantize(Vf<N> c, float depth, Vf<N> threshold)
+    {
+        // SATURATES WITH VECTOR MIN, SCALES TO DEPTH, A POWER OF TWO LESS ONE, AND TRUNCATES AS V3::COLOR DOES. NEGATIVE AND
+        // NAN CHANNELS ARE MASKED TO ZERO BY THE ORDERED COMPARE RATHER THAN A MAX, WHICH -OFAST MAY LOWER TO A MAXPS THAT
+        // PASSES NAN THROUGH TO FULL INTENSITY.
+        const auto q = __builtin_convertvector((min(c, 1.f) * depth + threshold).v, typename Mf<N>::Raw);
+        return __builtin_convertvector(q & (c > 0.f).v & int(depth), Vu<N>);
+    }
+
+    template<int N>
+    inline Vu<N> pack(Format format, Vf<N> r, Vf<N> g, Vf<N> b, Vf<N> threshold = Vf<N> {})
+    {
+        switch(format)
+        {
+        case Format::argb:
+            return quantize(b, 255.f, threshold) << 24 | quantize(g, 255.f, threshold) << 16 | quantize(r, 255.f, threshold) << 8 | 0xFFu;
+        case Format::rgb565:
+            return quantize(r, 31.f, threshold) << 11 | quantize(g, 63.f, threshold) << 5 | quantize(b, 31.f, threshold);
+        case Format::rgb10:
+            return 3u << 30 | quantize(r, 1023.f, threshold) << 20 | quantize(g, 1023.f, threshold) << 10 | quantize(b, 1023.f, threshold);
+        default:
+            return 0xFFu << 24 | quantize(r, 255.f, threshold) << 16 | quantize(g, 255.f, threshold) << 8 | quantize(b, 255.f, threshold);
+        }
+    }
+
+    inline Vf<lanes> bayer(int x, int y)
+    {
+        // 4X4 ORDERED DITHER THRESHOLDS IN [0, 1) FOR PIXELS X TO X + LANES - 1 OF ROW Y. LANES IS A MULTIPLE OF 4, SO EVERY
+        // PACKET OF A ROW STARTING AT X SHARES THEM.
+        constexpr int matrix[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+        auto t = Vf<lanes> {};
+        for(int i = 0; i < lanes; i++)
+            t.v[i] = (float(matrix[y & 3][(x + i) & 3]) + 0.5f) / 16.f;
+        return t;
+    }
+
+    inline void pack(Format format, const float* r, const float* g, const float* b, int count, int x, int y, bool dither, void* out)
+    {
+        // PACKS PIXELS X TO X + COUNT - 1 OF ROW Y FROM PLANES HOLDING WHOLE PACKETS. DITHERING ADDS A BAYER THRESHOLD BEFORE
+        // TRUNCATING, TRADING BANDS IN SMOOTH GRADIENTS FOR A FINE FIXED PATTERN. IT MATTERS MOST AT 5 AND 6 BITS.
+        using Half = uint16_t __attribute__((vector_size(2 * lanes)));
+        const auto threshold = dither ? bayer(x, y) : Vf<lanes> {};
+        const auto to = static_cast<uint8_t*>(out);
+        for(int i = 0; i < count; i += lanes)
+        {
+            Vf<lanes> cr, cg, cb;
+            std::memcpy(&cr.v, r + i, sizeof(cr.v));
+            std::memcpy(&cg.v, g + i, sizeof(cg.v));
+            std::memcpy(&cb.v, b + i, sizeof(cb.v));
+            const auto c = pack(format, cr, cg, cb, threshold);
+            // WHOLE PACKETS STORE AT A FIXED SIZE. ONLY A ROW'S LAST PACKET MAY BE PARTIAL.
+            const auto n = std::min(lanes, count - i);
+            if(format == Format::rgb565)
+            {
+                const auto h = __builtin_convertvector(c, Half);
+                if(n == lanes)
+                    std::memcpy(to + 2 * i, &h, sizeof(h));
+                else
+                    std::memcpy(to + 2 * i, &h, 2 * n);
+            }
+            else if(n == lanes)
+                std::memcpy(to + 4 * i, &c, sizeof(c));
+            else
+                std::memcpy(to + 4 * i, &c, 4 * n);
+        }
+    }
+
+    // PLANAR SHADERS RETURN A FLOAT V3 OR V3P COLOR, OPAQUE, INSTEAD OF A PACKED ONE. ARGB PACKS ANY SHADER'S RESULT.
+
+    inline uint32_t argb(uint32_t c)
+    {
+        return c;
+    }
+
+    inline Vu<lanes> argb(Vu<lanes> c)
+    {
+        return c;
+    }
+
+    inline uint32_t argb(V3 c)
+    {
+        return pack(Format::bgra, Vf<4> { c.x }, Vf<4> { c.y }, Vf<4> { c.z })[0];
+    }
+
+    inline Vu<lanes> argb(const V3p<lanes>& c)
+    {
+        return pack(Format::bgra, c.x, c.y, c.z);
+    }
+
+    // BATCH OPERATIONS RUN THE PACKET OVERLOADS ABOVE OVER EVERY LANE OF THEIR ARRAYS. OUTPUTS MAY ALIAS INPUTS.
+
+    inline void dot(const V3Array& x, const V3Array& y, FArray& out)
+    {
+        for(int i = 0; i < out.padded; i += lanes)
+            out.store(0, i, dot(load(x, i), load(y, i)));
+    }
+
+    inline void normalize(const V3Array& v, V3Array& out)
+    {
+        for(int i = 0; i < out.padded; i += lanes)
+            store(out, i, normalize(load(v, i)));
+    }
+
+    inline void reflect(const V3Array& i, const V3Array& n, V3Array& out)
+    {
+        for(int j = 0; j < out.padded; j += lanes)
+            store(out, j, reflect(load(i, j), load(n, j)));
+    }
+
+    inline void mix(const V3Array& x, const V3Array& y, float a, V3Array& out)
+    {
+        for(int i = 0; i < out.padded; i += lanes)
+            store(out, i, mix(load(x, i), load(y, i), Vf<lanes> { a }));
+    }
+
+    inline void mix(const V3Array& x, const V3Array& y, const FArray& a, V3Array& out)
+    {
+        for(int i = 0; i < out.padded; i += lanes)
+            store(out, i, mix(load(x, i), load(y, i), a.load(0, i)));
+    }
+
+    inline void mul(const V3Array& v, M3 m, V3Array& out)
+    {
+        for(int i = 0; i < out.padded; i += lanes)
+            store(out, i, mul(load(v, i), m));
+    }
+
+    inline void mul(M3 m, const V3Array& v, V3Array& out)
+    {
+        for(int i = 0; i < out.padded; i += lanes)
+            store(out, i, m * load(v, i));
+    }
+
+    // SQUARE POWER OF TWO SINGLE CHANNEL TEXTURES. TEXELS ARE STORED IN MORTON (Z) ORDER SO THE 2X2 FOOTPRINT OF A
+    // BILINEAR FETCH, AND THE NEIGHBOURING FOOTPRINTS OF A PACKET, MOSTLY SHARE CACHE LINES. COORDINATES ARE IN TEXELS
+    // WITH TEXEL (X, Y) SITTING ON THE INTEGER LATTICE POINT (X, Y), THE SAME CONVENTION AS VALUE NOISE.
+
+    enum class Wrap
+    {
+        repeat,
+        clamp,
+        mirror,
+    };
+
+    class Texture
+    {
+        float* data {};
+
+        static int ceil2(int x)
+        {
+            auto p = 1;
+            while(p < x && p < 65536)
+                p *= 2;
+            return p;
+        }
+
+        template<typename T>
+        static T spread(T x)
+        {
+            x &= 0xFFFF;
+            x = (x | x << 8) & 0x00FF00FF;
+            x = (x | x << 4) & 0x0F0F0F0F;
+            x = (x | x << 2) & 0x33333333;
+            x = (x | x << 1) & 0x55555555;
+            return x;
+        }
+
+        template<typename T>
+        T wrapped(T x) const
+        {
+            // THE SAME CODE WRAPS ONE INT OR A WHOLE PACKET OF THEM.
+            const auto zero = T {};
+            const auto last = zero + (size - 1);
+            switch(wrap)
+            {
+            case Wrap::clamp:
+                x = x < zero ? zero : x;
+                return x > last ? last : x;
+            case Wrap::mirror:
+                x &= 2 * size - 1;
+                return x > last ? zero + (2 * size - 1) - x : x;
+            default:
+                return x & (size - 1);
+            }
+        }
+
+    public:
+        const int size {};
+        const Wrap wrap {};
+        // SIZES ARE ROUNDED UP TO A POWER OF TWO, AND CAPPED AT 65536 BY THE 32 BIT MORTON INDEX.
+        Texture(int side, Wrap wrap = Wrap::repeat)
+            : size { ceil2(side) }
+            , wrap { wrap }
+        {
+            data = static_cast<float*>(std::aligned_alloc(64, std::max(size_t(64), sizeof(*data) * size * size)));
+            std::fill(data, data + size_t(size) * size, 0.f);
+        }
+
+        template<typename F>
+        Texture(int side, Wrap wrap, F texel)
+            : Texture(side, wrap)
+        {
+            for(int y = 0; y < size; y++)
+                for(int x = 0; x < size; x++)
+                    at(x, y) = texel(x, y);
+        }
+
+        Texture(const Texture&) = delete;
+        Texture& operator=(const Texture&) = delete;
+
+        ~Texture()
+        {
+            std::free(data);
+        }
+
+        float& at(int x, int y)
+        {
+            return data[spread(uint32_t(x)) | spread(uint32_t(y)) << 1];
+        }
+
+        float fetch(int x, int y) const
+        {
+            return data[spread(uint32_t(wrapped(x))) | spread(uint32_t(wrapped(y))) << 1];
+        }
+
+        Vf<lanes> fetch(V2p<lanes> p) const
+        {
+            // P IS EXPECTED ON THE LATTICE. WRAPPING AND THE MORTON INDEX ARE DONE FOR THE WHOLE PACKET, THEN ONE HARDWARE
+            // GATHER LOADS IT WHERE THE TARGET HAS ONE.
+            using I = typename Mf<lanes>::Raw;
+            const auto x = wrapped(__builtin_convertvector(p.x.v, I));
+            const auto y = wrapped(__builtin_convertvector(p.y.v, I));
+            const auto index = spread(Vu<lanes>(x)) | spread(Vu<lanes>(y)) << 1;
+#if defined(__AVX512F__)
+            return Vf<lanes> { typename Vf<lanes>::Raw(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, __m512i(index), data, 4)) };
+#elif defined(__AVX2__)
+            return Vf<lanes> { typename Vf<lanes>::Raw(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), data, __m256i(index), _mm256_castsi256_ps(_mm256_set1_epi32(-1)), 4)) };
+#else
+            auto f = Vf<lanes> {};
+            for(int i = 0; i < lanes; i++)
+                f.v[i] = data[index[i]];
+            return f;
+#endif
+        }
+
+        float nearest(V2 p) const
+        {
+            return fetch(int(std::floor(p.x + 0.5f)), int(std::floor(p.y + 0.5f)));
+        }
+
+        Vf<lanes> nearest(V2p<lanes> p) const
+        {
+            return fetch(floor(p + 0.5f));
+        }
+
+        float bilinear(V2 p) const
+        {
+            const auto x = std::floor(p.x);
+            const auto y = std::floor(p.y);
+            const auto i = int(x);
+            const auto j = int(y);
+            const auto u = p.x - x;
+            const auto v = p.y - y;
+            const auto top = fetch(i, j) + (fetch(i + 1, j) - fetch(i, j)) * u;
+            const auto bot = fetch(i, j + 1) + (fetch(i + 1, j + 1) - fetch(i, j + 1)) * u;
+            return top + (bot - top) * v;
+        }
+
+        Vf<lanes> bilinear(V2p<lanes> p) const
+        {
+            const auto i = floor(p);
+            const auto f = p - i;
+            const auto a = fetch(i);
+            const auto b = fetch(i + V2 { 1.f, 0.f });
+            const auto c = fetch(i + V2 { 0.f, 1.f });
+            const auto d = fetch(i + V2 { 1.f, 1.f });
+            return mix(mix(a, b, f.x), mix(c, d, f.x), f.y);
+        }
+    };
+
+    // BUILT IN LOOKUP TABLES, BUILT ON FIRST USE. THE HASH TEXTURE HOLDS THE CLASSIC FRACT(SIN(DOT(P, (127.1, 311.7))) *
+    // 43758.5453) WHITE NOISE IN [0, 1) FOR EVERY LATTICE POINT, TILING EVERY 256. THE NOISE TEXTURE HOLDS SMOOTH VALUE
+    // NOISE IN [-1, 1] OVER THAT HASH, SAMPLED AT NOISE_DETAIL TEXELS PER LATTICE CELL AND TILING EVERY 256 TEXELS, SO
+    // BILINEAR(P * NOISE_DETAIL) STANDS IN FOR A WHOLE VALUE NOISE CALL.
+
+    const auto noise_detail = 4;
+
+    inline const Texture& hash_texture()
+    {
+        static const auto texture = Texture { 256, Wrap::repeat, [](int x, int y) {
+                                                 const auto h = std::sin(x * 127.1f + y * 311.7f) * 43758.5453123f;
+                                                 return h - std::floor(h);
+                                             } };
+        return texture;
+    }
+
+    inline const Texture& noise_texture()
+    {
+        static const auto texture = Texture { 256, Wrap::repeat, [](int x, int y) {
+                                                 const auto cells = 256 / noise_detail;
+                                                 const auto i = x / noise_detail;
+                                                 const auto j = y / noise_detail;
+                                                 const auto s = float(x % noise_detail) / noise_detail;
+                                                 const auto t = float(y % noise_detail) / noise_detail;
+                                                 const auto u = s * s * (3.f - 2.f * s);
+                                                 const auto v = t * t * (3.f - 2.f * t);
+                                                 const auto& hash = hash_texture();
+                                                 const auto a = hash.fetch(i % cells, j % cells);
+                                                 const auto b = hash.fetch((i + 1) % cells, j % cells);
+                                                 const auto c = hash.fetch(i % cells, (j + 1) % cells);
+                                                 const auto d = hash.fetch((i + 1) % cells, (j + 1) % cells);
+                                                 const auto top = a + (b - a) * u;
+                                                 const auto bot = c + (d - c) * u;
+                                                 return (top + (bot - top) * v) * 2.f - 1.f;
+                                             } };
+        return texture;
+    }
+
+    // FAST MATH TIER. MAX ERRORS WERE MEASURED AGAINST LIBM OVER A DENSE SWEEP OF THE STATED RANGE:
+    //
+    //     sin, cos   |x| < 2^24         2e-7 ABSOLUTE (THE SEASCAPE HASH ALONE REACHES |x| ~ 1e5)
+    //     atan2      ALL QUADRANTS      2e-6 RADIANS
+    //     pow        x IN [1e-4, 1e4]   8e-6 RELATIVE FOR |n * log2(x)| < 64, AND 0 FOR x <= 0
+    //
+    // THE SAME TEMPLATES SERVE FLOAT AND VF<N>. BITS<T> HIDES THE SCALAR / VECTOR REINTERPRET AND CONVERT.
+
+    namespace fast
+    {
+        template<typename T>
+        struct Bits;
+
+        template<>
+        struct Bits<float>
+        {
+            using I = int32_t;
+            static I bits(float f)
+            {
+                return __builtin_bit_cast(I, f);
+            }
+            static float real(I i)
+            {
+                return __builtin_bit_cast(float, i);
+            }
+            static float widen(I i)
+            {
+                return float(i);
+            }
+            static I narrow(float f)
+            {
+                return I(f);
+            }
+            static double wide(float f)
+            {
+                return double(f);
+            }
+            static float thin(double d)
+            {
+                return float(d);
+            }
+            static double floor(double d)
+            {
+                return std::floor(d);
+            }
+        };
+
+        template<int N>
+        struct Bits<Vf<N>>
+        {
+            using I = typename Mf<N>::Raw;
+            using F = typename Vf<N>::Raw;
+            static I bits(Vf<N> f)
+            {
+                return (I)f.v;
+            }
+            static Vf<N> real(I i)
+            {
+                return Vf<N> { (F)i };
+            }
+            static Vf<N> widen(I i)
+            {
+                return Vf<N> { __builtin_convertvector(i, F) };
+            }
+            static I narrow(Vf<N> f)
+            {
+                return __builtin_convertvector(f.v, I);
+            }
+            static typename Register<N>::D wide(Vf<N> f)
+            {
+                return __builtin_convertvector(f.v, typename Register<N>::D);
+            }
+            static Vf<N> thin(const typename Register<N>::D& d)
+            {
+                return Vf<N> { __builtin_convertvector(d, F) };
+            }
+            static typename Register<N>::D floor(const typename Register<N>::D& d)
+            {
+                auto t = d;
+                for(int i = 0; i < N; i++)
+                    t[i] = std::floor(t[i]);
+                return t;
+            }
+        };
+
+        template<typename T>
+        inline T wave(T x, double phase)
+        {
+            // SIN(x + phase). x + phase = k * PI + r WITH r IN [-PI/2, PI/2] IS SPLIT IN DOUBLE, WHERE k * PI KEEPS ITS LOW
+            // BITS FOR ANY k A FLOAT ARGUMENT CAN GIVE, THEN SIN(r) IS AN ODD DEGREE 11 POLYNOMIAL TIMES (-1)^k.
+            const auto d = Bits<T>::wide(x) + phase;
+            const auto k = Bits<T>::floor(d * 0.318309886183790672 + 0.5);
+            const auto r = Bits<T>::thin(d - k * 3.14159265358979324);
+            const auto sign = Bits<T>::thin(1. - (k - Bits<T>::floor(k * 0.5) * 2.) * 2.);
+            const auto r2 = r * r;
+            const auto p = r + r * r2 * (-1.66666667e-1f + r2 * (8.33333333e-3f + r2 * (-1.98412698e-4f + r2 * (2.75573192e-6f + r2 * -2.50521084e-8f))));
+            return p * sign;
+        }
+
+        template<typename T>
+        T sin(T x)
+        {
+            return wave(x, 0.);
+        }
+
+        template<typename T>
+        T cos(T x)
+        {
+            return wave(x, 1.57079632679489662);
+        }
+
+        template<typename T>
+        T atan2(T y, T x)
+        {
+            // ODD MINIMAX POLYNOMIAL FOR ATAN ON [0, 1], THEN OCTANT FIXUPS.
+            const auto ax = abs(x);
+            const auto ay = abs(y);
+            const auto steep = ay > ax;
+            const auto hi = select(steep, ay, ax);
+            const auto lo = select(steep, ax, ay);
+            const auto t = select(hi == 0.f, 0.f, lo / hi);
+            const auto t2 = t * t;
+            auto a = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+            a = select(steep, PI * 0.5f - a, a);
+            a = select(x < 0.f, PI - a, a);
+            return select(y < 0.f, -a, a);
+        }
+
+        template<typename T>
+        T exp2(T x)
+        {
+            // 2^x = 2^i * 2^f WITH f IN [-0.5, 0.5]. 2^i IS BUILT DIRECTLY IN THE EXPONENT BITS.
+            // NAN FAILS BOTH COMPARISONS AND LANDS ON -126, SO THE INT32 CONVERSION BELOW ALWAYS SEES A SMALL VALUE.
+            x = select(x > -126.f, select(x < 126.f, x, 126.f), -126.f);
+            const auto i = floor(x + 0.5f);
+            const auto f = x - i;
+            const auto p = 1.f + f * (6.93147181e-1f + f * (2.40226507e-1f + f * (5.55041087e-2f + f * (9.61812911e-3f + f * (1.33335581e-3f + f * 1.54035304e-4f)))));
+            return Bits<T>::real((Bits<T>::narrow(i) + 127) << 23) * p;
+        }
+
+        template<typename T>
+        T log2(T x)
+        {
+            // x = 2^e * m WITH m RECENTERED TO [SQRT(0.5), SQRT(2)], THEN LN(m) = 2 ATANH((m - 1) / (m + 1)).
+            const auto b = Bits<T>::bits(x);
+            auto e = Bits<T>::widen(((b >> 23) & 0xFF) - 127);
+            auto m = Bits<T>::real((b & 0x7FFFFF) | 0x3F800000);
+            const auto big = m > 1.41421356f;
+            m = select(big, m * 0.5f, m);
+            e = e + select(big, 1.f, 0.f);
+            const auto t = (m - 1.f) / (m + 1.f);
+            const auto t2 = t * t;
+            const auto ln = t * (2.f + t2 * (0.666666667f + t2 * (0.4f + t2 * 0.285714286f)));
+            return e + ln * 1.44269504f;
+        }
+
+        template<typename T>
+        T pow(T x, float n)
+        {
+            return select(x > 0.f, exp2(log2(x) * n), 0.f);
+        }
+    }
+}
+
+// HEADERS INCLUDES ARE SPLIT TO NOT POLLUTE SOFTSHADER MATH LIBRARY WITH OLD CSTYLE DECLARATIONS.
+
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <SDL2/SDL.h>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+namespace ss
+{
+#ifdef SS_STATIC_RES
+    // COMPILE TIME RESOLUTION, KEPT TO BENCHMARK THE RUNTIME RESOLUTION AGAINST. SS_XRES AND SS_YRES ARE IGNORED.
+    const auto xres = 768;
+    const auto yres = 432;
+
+    const auto res = V2 { float { xres }, float { yres } };
+
+    inline void resize(int, int)
+    {
+    }
+#else
+    inline auto xres = 768;
+    inline auto yres = 432;
+
+    inline auto res = V2 { float(xres), float(yres) };
+
+    inline void resize(int w, int h)
+    {
+        // SET AT STARTUP, BEFORE ANY FRAMEBUFFER, TILE OR SHADER READS THEM, AND BY THE HOST BETWEEN JOBS.
+        if(w <= 0 || h <= 0)
+            return;
+        xres = w;
+        yres = h;
+        res = V2 { float(w), float(h) };
+    }
+#endif
+
+    inline auto time = 0.f;
+
+    inline float uptime()
+    {
+        return time;
+    }
+
+    using Shade = uint32_t (*)(const V2);
+
+    using Pack = Vu<lanes> (*)(const V2p<lanes>);
+
+    // SHADERS ARE ANY CALLABLE TAKING A V2 (ONE PIXEL) OR A V2P<LANES> (ONE PACKET), AND OPTIONALLY THE UNIFORMS OF THE
+    // FRAME AS A SECOND ARGUMENT. THE UNIFORMS ARE SNAPSHOT ONCE PER DRAW, SO AN INLINED SHADER KEEPS THEM IN REGISTERS
+    // ACROSS THE WHOLE PIXEL LOOP. A PLAIN FUNCTION IS CALLED THROUGH A POINTER FOR EVERY PIXEL OR PACKET, WHILE
+    // SS::SHADER<F> GIVES IT A TYPE OF ITS OWN SO RUN, DRAW AND THE SPANS ARE SPECIALIZED FOR IT AND IT INLINES.
+    // BUILDING WITH -DSS_INDIRECT MAKES SS::SHADER<F> THE PLAIN FUNCTION POINTER AGAIN FOR COMPARISON.
+
+    struct Uniforms
+    {
+        V2 res {};
+        float time {};
+    };
+
+    inline Uniforms uniforms()
+    {
+        return Uniforms { res, time };
+    }
+
+    template<typename S, typename C>
+    auto call(const S& shade, C coord, const Uniforms& u) -> decltype(shade(coord, u))
+    {
+        return shade(coord, u);
+    }
+
+    template<typename S, typename C>
+    auto call(const S& shade, C coord, const Uniforms&) -> decltype(shade(coord))
+    {
+        return shade(coord);
+    }
+
+    template<typename S>
+    struct Bound
+    {
+        S shade {};
+        Uniforms uniforms {};
+        template<typename C>
+        auto operator()(C coord) const -> decltype(call(shade, coord, uniforms))
+        {
+            return call(shade, coord, uniforms);
+        }
+    };
+
+    template<typename S>
+    constexpr bool packet = std::is_invocable_v<const S&, V2p<lanes>> || std::is_invocable_v<const S&, V2p<lanes>, const Uniforms&>;
+
+    template<typename S>
+    constexpr bool planar = [] {
+        if constexpr(std::is_invocable_v<const S&, V2p<lanes>>)
+            return std::is_same_v<std::invoke_result_t<const S&, V2p<lanes>>, V3p<lanes>>;
+        else if constexpr(std::is_invocable_v<const S&, V2>)
+            return std::is_same_v<std::invoke_result_t<const S&, V2>, V3>;
+        else
+            return false;
+    }();
+
+    template<auto F>
+    struct Static
+    {
+        template<typename... A>
+        auto operator()(A... a) const -> decltype(F(a...))
+        {
+            return F(a...);
+        }
+    };
+
+#ifdef SS_INDIRECT
+    template<auto F>
+    constexpr auto shader = F;
+#else
+    template<auto F>
+    constexpr auto shader = Static<F> {};
+#endif
+
+    inline int option(const char* name, int fallback)
+    {
+        // RUNTIME KNOBS ARE READ FROM SS_* ENVIRONMENT VARIABLES SO THE SHADER MAINS STAY UNTOUCHED.
+        const auto value = std::getenv(name);
+        return value ? std::atoi(value) : fallback;
+    }
+
+    inline void tick()
+    {
+        time = SDL_GetTicks() * 0.001f;
+    }
+
+    // BUILDING WITH -DSS_TRACE RECORDS A TIMED SPAN PER TILE, FLUSH, DRAW, UPLOAD AND PRESENT INTO PER THREAD RINGS.
+    // ON EXIT THE RINGS ARE WRITTEN TO SS_TRACE_FILE (DEFAULT TRACE.JSON) AS CHROME TRACE EVENTS FOR CHROME://TRACING
+    // OR PERFETTO, AND A ONE LINE PER FRAME SUMMARY GOES TO STDERR. WITHOUT SS_TRACE EVERY CALL BELOW IS EMPTY.
+
+#ifdef SS_TRACE
+    struct Event
+    {
+        const char* name {};
+        uint32_t frame {};
+        int64_t begin {};
+        int64_t end {};
+    };
+
+    class Ring
+    {
+        // ONLY THE OWNING THREAD PUSHES. ONCE FULL THE OLDEST EVENTS ARE OVERWRITTEN, SO RECORDING NEVER BLOCKS.
+        std::vector<Event> events {};
+        std::atomic<uint64_t> head {};
+
+    public:
+        const std::string name {};
+        Ring(std::string name, int size)
+            : events(size)
+            , name { std::move(name) }
+        {
+        }
+
+        void push(const Event& event)
+        {
+            const auto h = head.load(std::memory_order_relaxed);
+            events[h % events.size()] = event;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        template<typename F>
+        void each(F f) const
+        {
+            const auto h = head.load(std::memory_order_acquire);
+            for(auto i = h > events.size() ? h - events.size() : 0; i < h; i++)
+                f(events[i % events.size()]);
+        }
+    };
+
+    inline int64_t now()
+    {
+        const auto t = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count();
+    }
+
+    class Trace
+    {
+        std::mutex mutex {};
+        std::vector<std::unique_ptr<Ring>> rings {};
+
+        struct Stats
+        {
+            double draw {};
+            double shade {};
+            double upload {};
+            double present {};
+        };
+
+        void save(const char* path, int64_t origin) const
+        {
+            const auto file = std::fopen(path, "w");
+            if(!file)
+                return;
+            std::fprintf(file, "{\"traceEvents\": [\n");
+            auto comma = "";
+            for(size_t tid = 0; tid < rings.size(); tid++)
+            {
+                std::fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %zu, \"args\": {\"name\": \"%s\"}}", comma, tid, rings[tid]->name.c_str());
+                comma = ",\n";
+                rings[tid]->each([&](const Event& e) {
+                    std::fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %zu, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %u}}",
+                        e.name, tid, 1e-3 * double(e.begin - origin), 1e-3 * double(e.end - e.begin), e.frame);
+                });
+            }
+            std::fprintf(file, "\n]}\n");
+            std::fclose(file);
+        }
+
+        void summarize(int workers) const
+        {
+            // IDLE IS THE POOL'S SHARE OF DRAW TIME NOT SPENT IN A TILE: WAKE UP LATENCY, STEALING AND WAITING ON THE LAST TILE.
+            auto stats = std::vector<Stats>(frame);
+            for(auto& ring : rings)
+                ring->each([&](const Event& e) {
+                    if(e.frame == 0 || e.frame > stats.size())
+                        return;
+                    auto& s = stats[e.frame - 1];
+                    const auto dt = 1e-6 * double(e.end - e.begin);
+                    if(std::strcmp(e.name, "draw") == 0)
+                        s.draw += dt;
+                    else if(std::strcmp(e.name, "tile") == 0 || std::strcmp(e.name, "pass") == 0 || std::strcmp(e.name, "upscale") == 0)
+                        s.shade += dt;
+                    else if(std::strcmp(e.name, "upload") == 0)
+                        s.upload += dt;
+                    else if(std::strcmp(e.name, "present") == 0)
+                        s.present += dt;
+                });
+            for(size_t i = 0; i < stats.size(); i++)
+            {
+                const auto& s = stats[i];
+                const auto idle = std::max(0.0, s.draw * workers - s.shade) / workers;
+                std::fprintf(stderr, "{\"frame\": %zu, \"draw_ms\": %.3f, \"shade_ms\": %.3f, \"idle_ms\": %.3f, \"upload_ms\": %.3f, \"present_ms\": %.3f}\n",
+                    i + 1, s.draw, s.shade / workers, idle, s.upload, s.present);
+            }
+        }
+
+    public:
+        std::atomic<uint32_t> frame {};
+        int workers {};
+
+        Ring* ring(const char* name, int index)
+        {
+            const auto size = option("SS_TRACE_EVENTS", 1 << 16);
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            if(std::strcmp(name, "worker") == 0)
+                workers++;
+            rings.push_back(std::make_unique<Ring>(index < 0 ? std::string { name } : name + std::string { " " } + std::to_string(index), size));
+            return rings.back().get();
+        }
+
+        ~Trace()
+        {
+            if(rings.empty())
+                return;
+            auto origin = INT64_MAX;
+            for(auto& ring : rings)
+                ring->each([&](const Event& e) { origin = std::min(origin, e.begin); });
+            const auto path = std::getenv("SS_TRACE_FILE");
+            save(path ? path : "trace.json", origin);
+            summarize(std::max(1, workers));
+        }
+    };
+
+    inline Trace trace {};
+
+    inline thread_local Ring* ring {};
+
+    inline void label(const char* name, int index = -1)
+    {
+        ring = trace.ring(name, index);
+    }
+
+    inline uint32_t advance()
+    {
+        return trace.frame.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    class Span
+    {
+        const char* name {};
+        const uint32_t frame {};
+        const int64_t begin {};
+
+    public:
+        Span(const char* name, uint32_t frame = trace.frame.load(std::memory_order_relaxed))
+            : name { name }
+            , frame { frame }
+            , begin { now() }
+        {
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        ~Span()
+        {
+            if(!ring)
+                label("thread");
+            ring->push(Event { name, frame, begin, now() });
+        }
+    };
+#else
+    inline void label(const char*, int = -1)
+    {
+    }
+
+    inline uint32_t advance()
+    {
+        return 0;
+    }
+
+    class Span
+    {
+    public:
+        Span(const char*, uint32_t = 0)
+        {
+        }
+
+        ~Span()
+        {
+        }
+    };
+#endif
+
+    class Video
+    {
+        SDL_Window* window {};
+        SDL_Renderer* renderer {};
+
+    public:
+        SDL_Texture* texture {};
+        Video()
+        {
+            window = SDL_CreateWindow("SOFTSHADER", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, xres, yres, SDL_WINDOW_SHOWN);
+            renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, xres, yres);
+        }
+
+        void render()
+        {
+            SDL_RenderCopy(renderer, texture, NULL, NULL);
+            SDL_RenderPresent(renderer);
+        }
+
+        ~Video()
+        {
+            SDL_DestroyWindow(window);
+            SDL_DestroyRenderer(renderer);
+            SDL_DestroyTexture(texture);
+            SDL_Quit();
+        }
+    };
+
+    inline std::vector<int> cpulist(const char* text)
+    {
+        // PARSES A CPU LIST LIKE 0-3,8,10-11, THE FORMAT OF SS_PIN AND OF /SYS/DEVICES/SYSTEM. A MALFORMED LIST IS EMPTY.
+        auto cpus = std::vector<int> {};
+        for(auto at = text; *at != '\0' && *at != '\n';)
+        {
+            char* end;
+            const auto first = int(std::strtol(at, &end, 10));
+            auto last = first;
+            if(end == at)
+                return {};
+            if(*end == '-')
+            {
+                at = end + 1;
+                last = int(std::strtol(at, &end, 10));
+                if(end == at)
+                    return {};
+            }
+            if(first < 0 || last < first)
+                return {};
+            for(int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+            at = end;
+            if(*at == ',')
+                at++;
+            else if(*at != '\0' && *at != '\n')
+                return {};
+        }
+        return cpus;
+    }
+
+    inline std::string slurp(const std::string& path)
+    {
+        auto text = std::string {};
+        if(const auto file = std::fopen(path.c_str(), "r"))
+        {
+            char chunk[256];
+            for(size_t n; (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0;)
+                text.append(chunk, n);
+            std::fclose(file);
+        }
+        return text;
+    }
+
+    struct Cpu
+    {
+        int id {};
+        int core {};
+        int package {};
+        int node {};
+        // WHICH OF ITS CORE'S SMT SIBLINGS THIS IS, 0 FOR THE FIRST.
+        int thread {};
+    };
+
+    class Placement
+    {
+        // WHERE THE POOL'S WORKERS RUN. SS_PIN=CORES PINS ONE WORKER PER PHYSICAL CORE AND LEAVES THE SMT SIBLINGS IDLE, SO
+        // NO TWO WORKERS SHARE A CORE'S FP UNITS. SS_PIN=SMT PINS ONE PER HARDWARE THREAD, USING EVERY CORE ONCE BEFORE ANY
+        // SIBLING. IN BOTH, CORES ARE ORDERED BY NUMA NODE, SO NEIGHBOURING WORKERS, WHICH START ON NEIGHBOURING TILES, SHARE
+        // A NODE. SS_PIN=0,2,4-7 PINS WORKER I TO THE I-TH LISTED CPU. WITHOUT SS_PIN THE OS PLACES THE WORKERS. SS_THREADS
+        // SETS THE WORKER COUNT, BY DEFAULT ONE PER PINNED CPU OR ONE PER CPU. EXTRA WORKERS WRAP AROUND THE PINNED CPUS.
+        static std::vector<Cpu> topology()
+        {
+            // READ FROM /SYS ON LINUX. ELSEWHERE, OR WITHOUT /SYS, EVERY CPU IS ITS OWN CORE ON NODE 0.
+            auto cpus = std::vector<Cpu> {};
+#ifdef __linux__
+            const auto root = std::string { "/sys/devices/system/" };
+            for(auto id : cpulist(slurp(root + "cpu/online").c_str()))
+            {
+                const auto dir = root + "cpu/cpu" + std::to_string(id) + "/topology/";
+                const auto siblings = cpulist(slurp(dir + "thread_siblings_list").c_str());
+                const auto thread = std::find(siblings.begin(), siblings.end(), id) - siblings.begin();
+                const auto core = std::atoi(slurp(dir + "core_id").c_str());
+                const auto package = std::atoi(slurp(dir + "physical_package_id").c_str());
+                cpus.push_back(Cpu { id, core, package, 0, thread < int(siblings.size()) ? int(thread) : 0 });
+            }
+            for(auto node : cpulist(slurp(root + "node/online").c_str()))
+                for(auto id : cpulist(slurp(root + "node/node" + std::to_string(node) + "/cpulist").c_str()))
+                    for(auto& cpu : cpus)
+                        if(cpu.id == id)
+                            cpu.node = node;
+#endif
+            if(cpus.empty())
+                for(int id = 0; id < SDL_GetCPUCount(); id++)
+                    cpus.push_back(Cpu { id, id, 0, 0, 0 });
+            return cpus;
+        }
+
+    public:
+        // THE PINNED CPUS IN WORKER ORDER, EMPTY WHEN UNPINNED.
+        std::vector<Cpu> cpus {};
+        int workers {};
+        Placement()
+        {
+            const auto pin = std::getenv("SS_PIN");
+            auto all = topology();
+            if(pin && (std::strcmp(pin, "cores") == 0 || std::strcmp(pin, "smt") == 0))
+            {
+                std::sort(all.begin(), all.end(), [](const Cpu& a, const Cpu& b) {
+                    return std::tie(a.thread, a.node, a.package, a.core, a.id) < std::tie(b.thread, b.node, b.package, b.core, b.id);
+                });
+                for(const auto& cpu : all)
+                    if(cpu.thread == 0 || std::strcmp(pin, "smt") == 0)
+                        cpus.push_back(cpu);
+            }
+            else if(pin)
+            {
+                for(auto id : cpulist(pin))
+                {
+                    const auto cpu = std::find_if(all.begin(), all.end(), [&](const Cpu& cpu) { return cpu.id == id; });
+                    if(cpu == all.end())
+                    {
+                        cpus.clear();
+                        break;
+                    }
+                    cpus.push_back(*cpu);
+                }
+                if(cpus.empty())
+                    std::fprintf(stderr, "placement: SS_PIN=%s is not cores, smt or a list of online cpus, leaving workers unpinned\n", pin);
+            }
+            workers = std::max(1, option("SS_THREADS", cpus.empty() ? SDL_GetCPUCount() : int(cpus.size())));
+        }
+
+        int cpu(int worker) const
+        {
+            return cpus.empty() ? -1 : cpus[worker % cpus.size()].id;
+        }
+
+        void pin([[maybe_unused]] int worker) const
+        {
+            // ONLY LINUX PINS. ELSEWHERE THE WORKERS STAY WHERE THE OS PUTS THEM.
+#ifdef __linux__
+            if(cpus.empty())
+                return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu(worker), &set);
+            if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+                std::fprintf(stderr, "placement: cannot pin worker %d to cpu %d\n", worker, cpu(worker));
+#endif
+        }
+    };
+
+    inline const Placement& placement()
+    {
+        static const auto placed = Placement {};
+        return placed;
+    }
+
+    class Vram
+    {
+        uint32_t* pixels {};
+        uint32_t* buffer {};
+        int stride {};
+        bool streaming {};
+        SDL_Texture* texture {};
+        // FLOAT RED, GREEN AND BLUE PLANES, KEPT ONLY FOR OUTPUTS DEEPER THAN THE 8 BIT FRAMEBUFFER. ROWS ARE PADDED TO
+        // WHOLE PACKETS SO THEY PACK LIKE THE WORKERS' FLOAT TILES.
+        float* planes {};
+        int pad {};
+
+    public:
+        const int cpus {};
+        int width {};
+        int height {};
+        // SET WHEN EVERY PIXEL OF THE LAST FRAME CAME THROUGH THE FLOAT PACK STAGE.
+        bool planar {};
+        Vram()
+            : cpus { placement().workers }
+        {
+        }
+
+        Vram(const Vram&) = delete;
+        Vram& operator=(const Vram&) = delete;
+
+        ~Vram()
+        {
+            std::free(buffer);
+            std::free(planes);
+        }
+
+        void own(bool stream = true)
+        {
+            own(xres, yres, stream);
+        }
+
+        void own(int w, int h, bool stream = true)
+        {
+            // HEADLESS FRAMEBUFFER. ROWS ARE PADDED TO 16 PIXELS SO EACH ONE STARTS ON A CACHE LINE.
+            std::free(buffer);
+            width = w;
+            height = h;
+            stride = (w + 15) / 16 * 16;
+            buffer = static_cast<uint32_t*>(std::aligned_alloc(64, sizeof(*buffer) * stride * h));
+            pixels = buffer;
+            streaming = stream;
+            if(planes)
+            {
+                std::free(planes);
+                planes = nullptr;
+                deepen(true);
+            }
+        }
+
+        void deepen(bool deep)
+        {
+            if(deep == (planes != nullptr))
+                return;
+            std::free(planes);
+            planes = nullptr;
+            planar = false;
+            if(!deep)
+                return;
+            pad = (width + lanes - 1) / lanes * lanes;
+            const auto bytes = sizeof(*planes) * 3 * pad * height;
+            planes = static_cast<float*>(std::aligned_alloc(64, (bytes + 63) / 64 * 64));
+            std::memset(planes, 0, bytes);
+        }
+
+        bool deep() const
+        {
+            return planes && planar;
+        }
+
+        void keep(int x0, int x1, int y, const float* r, int plane)
+        {
+            // COPIES A PACKED ROW'S FLOAT COLORS, WHOSE PLANES ARE PLANE FLOATS APART, INTO THE FRAME'S OWN.
+            if(!planes)
+                return;
+            for(int c = 0; c < 3; c++)
+                std::memcpy(planes + (c * height + y) * pad + x0, r + c * plane, sizeof(*planes) * (x1 - x0));
+        }
+
+        const float* floats(int y, int c) const
+        {
+            return planes + (c * height + y) * pad;
+        }
+
+        void put(int x, int y, uint32_t color)
+        {
+            pixels[x + y * stride] = color;
+        }
+
+        uint32_t get(int x, int y) const
+        {
+            return pixels[x + y * stride];
+        }
+
+        const uint32_t* row(int y) const
+        {
+            return pixels + y * stride;
+        }
+
+        void stream(int x0, int x1, int y, const uint32_t* row)
+        {
+            // COPIES A SHADED ROW OUT WITH NON TEMPORAL STORES SO WRITE COMBINED TEXTURE MEMORY IS FILLED A WHOLE
+            // LINE AT A TIME AND THE FRAME DOES NOT EVICT THE SHADER'S WORKING SET. BUFFERS READ BACK SOON AFTER,
+            // LIKE THE ADAPTIVE CANVAS, ARE COPIED NORMALLY.
+            auto out = pixels + x0 + y * stride;
+            auto count = x1 - x0;
+#ifdef __SSE2__
+            if(streaming)
+            {
+                for(; count > 0 && reinterpret_cast<uintptr_t>(out) % 16; count--)
+                    *out++ = *row++;
+                for(; count >= 4; count -= 4, out += 4, row += 4)
+                    _mm_stream_si128(reinterpret_cast<__m128i*>(out), _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+            }
+#endif
+            std::memcpy(out, row, sizeof(*out) * count);
+        }
+
+        void clear(int x0, int x1, int y)
+        {
+            std::memset(pixels + x0 + y * stride, 0, sizeof(*pixels) * (x1 - x0));
+        }
+
+        void fence() const
+        {
+            // NON TEMPORAL STORES ARE WEAKLY ORDERED. EACH WORKER FENCES BEFORE REPORTING ITS PART OF THE FRAME DONE.
+#ifdef __SSE2__
+            if(streaming)
+                _mm_sfence();
+#endif
+        }
+
+        void upload(SDL_Texture* texture) const
+        {
+            SDL_UpdateTexture(texture, NULL, pixels, stride * int(sizeof(*pixels)));
+        }
+
+        void lock(SDL_Texture* texture)
+        {
+            void* raw;
+            int pitch;
+            SDL_LockTexture(texture, NULL, &raw, &pitch);
+            pixels = (uint32_t*)raw;
+            stride = pitch / int(sizeof(*pixels));
+            width = xres;
+            height = yres;
+            streaming = true;
+            this->texture = texture;
+        }
+
+        void unlock()
+        {
+            SDL_UnlockTexture(texture);
+        }
+    };
+
+    struct Tile
+    {
+        int x0 {};
+        int y0 {};
+        int x1 {};
+        int y1 {};
+    };
+
+    struct alignas(64) Deque
+    {
+        // A WORKER'S SHARE OF TILE INDICES. THE OWNER POPS FROM THE HEAD, THIEVES STEAL FROM THE TAIL.
+        // BOTH ENDS ARE PACKED INTO ONE WORD SO EITHER SIDE CLAIMS A TILE WITH A SINGLE CAS.
+        std::atomic<uint64_t> range {};
+
+        static uint64_t pack(uint32_t head, uint32_t tail)
+        {
+            return uint64_t { head } | uint64_t { tail } << 32;
+        }
+
+        void reset(int head, int tail)
+        {
+            range.store(pack(head, tail), std::memory_order_relaxed);
+        }
+
+        bool pop(int& tile)
+        {
+            auto r = range.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                const auto head = uint32_t(r);
+                const auto tail = uint32_t(r >> 32);
+                if(head >= tail)
+                    return false;
+                if(range.compare_exchange_weak(r, pack(head + 1, tail), std::memory_order_acq_rel))
+                {
+                    tile = head;
+                    return true;
+                }
+            }
+        }
+
+        bool steal(int& tile)
+        {
+            auto r = range.load(std::memory_order_relaxed);
+            for(;;)
+            {
+                const auto head = uint32_t(r);
+                const auto tail = uint32_t(r >> 32);
+                if(head >= tail)
+                    return false;
+                if(range.compare_exchange_weak(r, pack(head, tail - 1), std::memory_order_acq_rel))
+                {
+                    tile = tail - 1;
+                    return true;
+                }
+            }
+        }
+    };
+
+    class Pool
+    {
+        std::vector<std::thread> threads {};
+        std::mutex mutex {};
+        std::condition_variable wake {};
+        std::condition_variable done {};
+        std::function<void(int)> task {};
+        uint64_t frame {};
+        int busy {};
+        bool quit { false };
+
+        void work(const int id)
+        {
+            // WORKERS PARK ON THE CONDITION VARIABLE BETWEEN FRAMES AND ARE WOKEN ONCE PER DISPATCH.
+            label("worker", id);
+            placement().pin(id);
+            auto seen = uint64_t {};
+            for(;;)
+            {
+                {
+                    auto lock = std::unique_lock<std::mutex> { mutex };
+                    wake.wait(lock, [&] { return quit || frame != seen; });
+                    if(quit)
+                        return;
+                    seen = frame;
+                }
+                const auto t0 = std::chrono::high_resolution_clock::now();
+                task(id);
+                const auto t1 = std::chrono::high_resolution_clock::now();
+                {
+                    auto lock = std::lock_guard<std::mutex> { mutex };
+                    worked[id] += std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0).count();
+                    if(--busy == 0)
+                        done.notify_one();
+                }
+            }
+        }
+
+    public:
+        const int size {};
+        std::vector<double> worked {};
+        std::vector<double> flushed {};
+        std::vector<double> packed {};
+        Pool(int size)
+            : size { size }
+            , worked(size)
+            , flushed(size)
+            , packed(size)
+        {
+            for(int i = 0; i < size; i++)
+                threads.push_back(std::thread { [this, i] { work(i); } });
+        }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        void reset()
+        {
+            // ZEROES THE PER WORKER TIMES, SO SETUP DISPATCHES LIKE ALLOCATING AND PLACING BUFFERS DO NOT COUNT.
+            std::fill(worked.begin(), worked.end(), 0.0);
+            std::fill(flushed.begin(), flushed.end(), 0.0);
+            std::fill(packed.begin(), packed.end(), 0.0);
+        }
+
+        void dispatch(std::function<void(int)> job)
+        {
+            auto lock = std::unique_lock<std::mutex> { mutex };
+            task = std::move(job);
+            busy = size;
+            frame++;
+            wake.notify_all();
+            done.wait(lock, [&] { return busy == 0; });
+        }
+
+        ~Pool()
+        {
+            {
+                auto lock = std::lock_guard<std::mutex> { mutex };
+                quit = true;
+            }
+            wake.notify_all();
+            for(auto& thread : threads)
+                thread.join();
+        }
+    };
+
+    class Tiler
+    {
+        std::vector<Deque> deques {};
+        std::vector<uint32_t*> scratch {};
+        std::vector<float*> planes {};
+        const int size {};
+
+    public:
+        int width {};
+        int height {};
+        std::vector<Tile> tiles {};
+        // ROW PITCH OF THE SCRATCH TILES, ROUNDED UP TO WHOLE PACKETS SO SPANS STORE FULL VECTORS.
+        const int pitch {};
+        // FLOATS BETWEEN THE RED, GREEN AND BLUE PLANES OF A WORKER'S FLOAT TILE.
+        const int plane {};
+        // SS_DITHER=1 DITHERS THE PACK STAGE.
+        const bool dither {};
+        Tiler(Pool& pool, int side)
+            : deques(pool.size)
+            , scratch(pool.size)
+            , planes(pool.size)
+            , size { std::max(1, side) }
+            , pitch { (size + lanes - 1) / lanes * lanes }
+            , plane { pitch * size }
+            , dither { option("SS_DITHER", 0) != 0 }
+        {
+            // EACH WORKER SHADES INTO ITS OWN TILE SIZED BUFFER, SMALL ENOUGH TO STAY IN CACHE, BEFORE THE ROWS ARE STREAMED OUT.
+            // PLANAR SHADERS SHADE INTO A FLOAT TILE FIRST. WORKERS ALLOCATE AND CLEAR THEIR OWN, IN WHOLE PAGES, SO A PINNED
+            // WORKER'S BUFFERS ARE BACKED BY ITS OWN NUMA NODE.
+            const auto bytes = (sizeof(uint32_t) * pitch * size + 4095) / 4096 * 4096;
+            const auto floats = (sizeof(float) * 3 * plane + 4095) / 4096 * 4096;
+            pool.dispatch([&](int id) {
+                scratch[id] = static_cast<uint32_t*>(std::aligned_alloc(4096, bytes));
+                planes[id] = static_cast<float*>(std::aligned_alloc(4096, floats));
+                std::memset(scratch[id], 0, bytes);
+                std::memset(planes[id], 0, floats);
+            });
+            cut(xres, yres);
+        }
+
+        Tiler(const Tiler&) = delete;
+        Tiler& operator=(const Tiler&) = delete;
+
+        ~Tiler()
+        {
+            for(auto rows : scratch)
+                std::free(rows);
+            for(auto tile : planes)
+                std::free(tile);
+        }
+
+        uint32_t* rows(int worker) const
+        {
+            return scratch[worker];
+        }
+
+        float* floats(int worker) const
+        {
+            return planes[worker];
+        }
+
+        void pack(int worker, const Tile& tile, Vram& vram) const
+        {
+            // THE PACK STAGE. TURNS A WORKER'S FLOAT TILE INTO ITS SCRATCH ROWS, A WHOLE ROW PER CALL, AND KEEPS THE FLOATS
+            // TOO IF THE FRAME HAS PLANES FOR THEM.
+            for(int y = tile.y0; y < tile.y1; y++)
+            {
+                const auto at = (y - tile.y0) * pitch;
+                const auto r = planes[worker] + at;
+                ss::pack(Format::bgra, r, r + plane, r + 2 * plane, tile.x1 - tile.x0, tile.x0, y, dither, scratch[worker] + at);
+                vram.keep(tile.x0, tile.x1, y, r, plane);
+            }
+        }
+
+        void cut(int w, int h)
+        {
+            // TILES ARE CLIPPED AT THE RIGHT AND BOTTOM EDGES SO EVERY PIXEL IS COVERED FOR ANY RESOLUTION.
+            if(w == width && h == height)
+                return;
+            width = w;
+            height = h;
+            tiles.clear();
+            for(int y = 0; y < h; y += size)
+                for(int x = 0; x < w; x += size)
+                    tiles.push_back(Tile { x, y, std::min(x + size, w), std::min(y + size, h) });
+        }
+
+        void place(Pool& pool, Vram& vram)
+        {
+            // FIRST TOUCHES A NEWLY OWNED FRAMEBUFFER FROM THE WORKERS, EACH CLEARING THE RUN OF TILES IT STARTS EVERY FRAME
+            // WITH, SO LINUX BACKS THOSE ROWS WITH PAGES ON THE NODE OF THE WORKER THAT WRITES THEM. STOLEN TILES STILL CROSS.
+            cut(vram.width, vram.height);
+            const auto count = int(tiles.size());
+            pool.dispatch([&](int id) {
+                for(int i = count * id / pool.size; i < count * (id + 1) / pool.size; i++)
+                    for(int y = tiles[i].y0; y < tiles[i].y1; y++)
+                        vram.clear(tiles[i].x0, tiles[i].x1, y);
+            });
+        }
+
+        void reset()
+        {
+            // EACH WORKER STARTS WITH A CONTIGUOUS RUN OF TILES TO KEEP NEIGHBOURING ROWS ON ONE CORE.
+            const auto workers = int(deques.size());
+            const auto count = int(tiles.size());
+            for(int i = 0; i < workers; i++)
+                deques[i].reset(count * i / workers, count * (i + 1) / workers);
+        }
+
+        bool next(int worker, int& tile)
+        {
+            if(deques[worker].pop(tile))
+                return true;
+            const auto workers = int(deques.size());
+            for(int i = 1; i < workers; i++)
+                if(deques[(worker + i) % workers].steal(tile))
+                    return true;
+            return false;
+        }
+    };
+
+    class Input
+    {
+        const uint8_t* key {};
+        int held {};
+
+    public:
+        bool done { false };
+        // PAGE DOWN AND PAGE UP STEP THROUGH THE REGISTERED SHADERS, ONCE PER PRESS.
+        int step {};
+        Input()
+            : key { SDL_GetKeyboardState(NULL) }
+        {
+        }
+        void update()
+        {
+            SDL_Event event;
+            SDL_PollEvent(&event);
+            if(key[SDL_SCANCODE_END] || key[SDL_SCANCODE_ESCAPE] || event.type == SDL_QUIT)
+                done = true;
+            const auto down = key[SDL_SCANCODE_PAGEDOWN] - key[SDL_SCANCODE_PAGEUP];
+            step = down != held ? down : 0;
+            held = down;
+        }
+    };
+
+    // ZOOM MAPS A PIXEL CENTER OF A SMALLER CANVAS BACK TO SS::RES COORDINATES. A ZOOM OF 1 GIVES X AND Y EXACTLY.
+
+    inline uint32_t blend(uint32_t a, uint32_t b, uint32_t w)
+    {
+        // LERPS TWO CHANNELS AT A TIME WITH 8 BIT WEIGHTS.
+        const auto rb = ((a & 0xFF00FF) * (256 - w) + (b & 0xFF00FF) * w) >> 8 & 0xFF00FF;
+        const auto ag = ((a >> 8 & 0xFF00FF) * (256 - w) + (b >> 8 & 0xFF00FF) * w) & 0xFF00FF00;
+        return rb | ag;
+    }
+
+    // A MOTION HINT MAPS A PIXEL COORDINATE TO WHERE THAT POINT OF THE IMAGE WAS DT SECONDS AGO, GIVEN THE FRAME'S UNIFORMS.
+    using Motion = V2 (*)(const V2 coord, float dt, const Uniforms& u);
+
+    class Interleave
+    {
+        // SHADES ONE IN N PIXELS PER FRAME, THOSE WITH (X - Y - FRAME) MOD N == 0, SO THE SHADED DIAGONALS ROTATE THROUGH
+        // EVERY PIXEL IN N FRAMES. THE REST ARE FILLED FROM THE PREVIOUS FRAME, FOLLOWED BACK ALONG THE MOTION HINT IF THE
+        // SHADER GIVES ONE. THE PHASE COMES FROM A FRAME COUNTER, NOT THE CLOCK, SO BENCHMARK RUNS REPEAT EXACTLY. A FULL
+        // FRAME IS SHADED WHENEVER THE CANVAS SIZE CHANGES.
+        Vram history[2] {};
+        uint64_t frame {};
+        int width {};
+        int height {};
+        float last {};
+        Uniforms now {};
+
+    public:
+        const int n {};
+        Motion motion {};
+        int phase {};
+        bool full { true };
+        float dt {};
+        Interleave(int n, Motion motion)
+            : n { std::max(1, n) }
+            , motion { motion }
+        {
+            if(enabled())
+                for(auto& vram : history)
+                    vram.own(false);
+        }
+
+        bool enabled() const
+        {
+            return n > 1;
+        }
+
+        void restart(Motion hint)
+        {
+            // A NEW SHADER CANNOT FILL FROM ANOTHER SHADER'S HISTORY, SO ITS FIRST FRAME IS SHADED IN FULL.
+            motion = hint;
+            width = 0;
+            height = 0;
+        }
+
+        void begin(int w, int h)
+        {
+            if(!enabled())
+                return;
+            full = w != width || h != height;
+            width = w;
+            height = h;
+            phase = int(frame++ % uint64_t(n));
+            now = uniforms();
+            dt = now.time - last;
+            last = now.time;
+        }
+
+        const Vram& prev() const
+        {
+            return history[frame % 2];
+        }
+
+        Vram& next()
+        {
+            return history[(frame + 1) % 2];
+        }
+
+        int first(int x, int y) const
+        {
+            // SMALLEST SHADED X >= X ON ROW Y.
+            return full ? x : x + ((phase + y - x) % n + n) % n;
+        }
+
+        int step() const
+        {
+            return full ? 1 : n;
+        }
+
+        uint32_t fill(int x, int y, V2 zoom) const
+        {
+            if(!motion)
+                return prev().get(x, y);
+            // MOTION IS OFTEN UNDER A PIXEL PER FRAME, SO THE HISTORY IS SAMPLED BILINEARLY RATHER THAN SNAPPED.
+            const auto coord = motion(V2 { (x + 0.5f) * zoom.x - 0.5f, (y + 0.5f) * zoom.y - 0.5f }, dt, now);
+            const auto u = clamp((coord.x + 0.5f) / zoom.x - 0.5f, 0.f, width - 1.f);
+            const auto v = clamp((coord.y + 0.5f) / zoom.y - 0.5f, 0.f, height - 1.f);
+            const auto i0 = int(u);
+            const auto j0 = int(v);
+            const auto i1 = std::min(i0 + 1, width - 1);
+            const auto j1 = std::min(j0 + 1, height - 1);
+            const auto wx = uint32_t((u - i0) * 256.f);
+            const auto wy = uint32_t((v - j0) * 256.f);
+            const auto top = blend(prev().get(i0, j0), prev().get(i1, j0), wx);
+            const auto bot = blend(prev().get(i0, j1), prev().get(i1, j1), wx);
+            return blend(top, bot, wy);
+        }
+    };
+
+    class Samples
+    {
+        // SUPERSAMPLING PATTERNS AS OFFSETS FROM THE PIXEL CENTER, IN PIXELS. SAMPLES ARE AVERAGED IN LINEAR LIGHT,
+        // DECODING 8 BIT SHADER OUTPUT THROUGH A GAMMA 2.2 TABLE. THE MEAN IS ENCODED BACK THROUGH A TABLE INDEXED BY
+        // ITS SQUARE ROOT, WHICH KEEPS DARK TONES AS FINE AS THE 8 BIT INPUT WITHOUT A POW PER CHANNEL.
+        std::vector<V2> offsets { V2 { 0.f } };
+        float linear[256] {};
+        uint8_t encoded[4096] {};
+
+        void jitter(int columns, int rows)
+        {
+            // ONE SAMPLE PER STRATUM AT A FIXED HASHED POSITION, SO FRAMES AND BENCHMARK RUNS REPEAT EXACTLY.
+            offsets.clear();
+            for(int j = 0; j < rows; j++)
+                for(int i = 0; i < columns; i++)
+                {
+                    auto h = uint32_t(i * 73856093) ^ uint32_t(j * 19349663);
+                    h = (h ^ (h >> 13)) * 0x5BD1E995;
+                    const auto u = float(h & 0xFFFF) / 65536.f;
+                    const auto v = float(h >> 16) / 65536.f;
+                    offsets.push_back(V2 { (i + u) / columns - 0.5f, (j + v) / rows - 0.5f });
+                }
+        }
+
+    public:
+        Samples(const char* pattern)
+        {
+            for(int i = 0; i < 256; i++)
+                linear[i] = std::pow(i / 255.f, 2.2f);
+            for(int i = 0; i < 4096; i++)
+                encoded[i] = uint8_t(std::lround(255.f * std::pow(i / 4095.f, 2.f / 2.2f)));
+            const auto name = std::string { pattern ? pattern : "" };
+            if(name == "grid")
+                offsets = { V2 { -0.25f, -0.25f }, V2 { 0.25f, -0.25f }, V2 { -0.25f, 0.25f }, V2 { 0.25f, 0.25f } };
+            else if(name == "rgss")
+                offsets = { V2 { 0.125f, -0.375f }, V2 { 0.375f, 0.125f }, V2 { -0.125f, 0.375f }, V2 { -0.375f, -0.125f } };
+            else if(name == "jitter4")
+                jitter(2, 2);
+            else if(name == "jitter8")
+                jitter(4, 2);
+            else if(name == "jitter16")
+                jitter(4, 4);
+        }
+
+        int count() const
+        {
+            return int(offsets.size());
+        }
+
+        V2 operator[](int i) const
+        {
+            return offsets[i];
+        }
+
+        float decode(uint32_t color, int shift) const
+        {
+            return linear[color >> shift & 0xFF];
+        }
+
+        uint32_t encode(float sum) const
+        {
+            return encoded[int(std::sqrt(clamp(sum / count(), 0.f, 1.f)) * 4095.f + 0.5f)];
+        }
+
+        uint32_t resolve(float r, float g, float b, float a) const
+        {
+            const auto alpha = uint32_t(clamp(a / count(), 0.f, 1.f) * 255.f + 0.5f);
+            return alpha << 24 | encode(r) << 16 | encode(g) << 8 | encode(b);
+        }
+    };
+
+    // SPANS WRITE PIXEL X0 TO ROW[0]. ROW HOLDS X1 - X0 PIXELS ROUNDED UP TO WHOLE PACKETS. SHADING STARTS AT X AND
+    // SKIPS STEP PIXELS AT A TIME, WHICH IS X0 AND 1 UNLESS INTERLEAVED.
+
+    template<typename S>
+    inline void span(uint32_t* row, S shade, int x0, int x1, int y, V2 zoom, int x, int step, const Samples& samples)
+    {
+        if constexpr(!packet<S>)
+        {
+            const auto v = (y + 0.5f) * zoom.y - 0.5f;
+            for(; x < x1; x += step)
+            {
+                const auto coord = V2 { (x + 0.5f) * zoom.x - 0.5f, v };
+                if(samples.count() == 1)
+                {
+                    row[x - x0] = argb(shade(coord));
+                    continue;
+                }
+                auto r = 0.f, g = 0.f, b = 0.f, a = 0.f;
+                for(int s = 0; s < samples.count(); s++)
+                {
+                    const auto color = argb(shade(coord + samples[s] * zoom));
+                    r += samples.decode(color, 16);
+                    g += samples.decode(color, 8);
+                    b += samples.decode(color, 0);
+                    a += float(color >> 24) / 255.f;
+                }
+                row[x - x0] = samples.resolve(r, g, b, a);
+            }
+        }
+        else
+        {
+            // ROW PACKETS: LANE I SHADES PIXEL X + I * STEP. LANES PAST THE TILE EDGE LAND IN THE ROW PADDING AND ARE NOT FLUSHED.
+            // SUPERSAMPLED PACKETS SHADE ONE SAMPLE OF EVERY LANE PER CALL, SO COST GROWS WITH THE SAMPLE COUNT AND NOTHING ELSE.
+            const auto ramp = Vf<lanes>::ramp() * float(step) + 0.5f;
+            const auto v = (y + 0.5f) * zoom.y - 0.5f;
+            for(; x < x1; x += lanes * step)
+            {
+                const auto coord = V2p<lanes> { (ramp + float(x)) * zoom.x - 0.5f, v };
+                auto color = Vu<lanes> {};
+                if(samples.count() == 1)
+                    color = argb(shade(coord));
+                else
+                {
+                    float r[lanes] {}, g[lanes] {}, b[lanes] {}, a[lanes] {};
+                    for(int s = 0; s < samples.count(); s++)
+                    {
+                        const auto sample = argb(shade(coord + V2p<lanes> { samples[s] * zoom }));
+                        for(int i = 0; i < lanes; i++)
+                        {
+                            r[i] += samples.decode(sample[i], 16);
+                            g[i] += samples.decode(sample[i], 8);
+                            b[i] += samples.decode(sample[i], 0);
+                            a[i] += float(sample[i] >> 24) / 255.f;
+                        }
+                    }
+                    for(int i = 0; i < lanes; i++)
+                        color[i] = samples.resolve(r[i], g[i], b[i], a[i]);
+                }
+                if(step == 1)
+                    std::memcpy(row + x - x0, &color, sizeof(color));
+                else
+                    for(int i = 0, count = std::min(lanes, (x1 - x + step - 1) / step); i < count; i++)
+                        row[x - x0 + i * step] = color[i];
+            }
+        }
+    }
+
+    // PLANAR SPANS STORE THE FLOAT COLORS OF PIXELS X0 TO X1 OF ROW Y AT R[0], R[PLANE] AND R[2 * PLANE] FOR THE PACK STAGE.
+
+    template<typename S>
+    inline void span(float* r, int plane, S shade, int x0, int x1, int y, V2 zoom)
+    {
+        const auto v = (y + 0.5f) * zoom.y - 0.5f;
+        if constexpr(!packet<S>)
+            for(int x = x0; x < x1; x++)
+            {
+                const auto c = shade(V2 { (x + 0.5f) * zoom.x - 0.5f, v });
+                r[x - x0] = c.x;
+                r[x - x0 + plane] = c.y;
+                r[x - x0 + plane * 2] = c.z;
+            }
+        else
+        {
+            const auto ramp = Vf<lanes>::ramp() + 0.5f;
+            for(int x = x0; x < x1; x += lanes)
+            {
+                const auto c = shade(V2p<lanes> { (ramp + float(x)) * zoom.x - 0.5f, v });
+                std::memcpy(r + x - x0, &c.x.v, sizeof(c.x.v));
+                std::memcpy(r + x - x0 + plane, &c.y.v, sizeof(c.y.v));
+                std::memcpy(r + x - x0 + plane * 2, &c.z.v, sizeof(c.z.v));
+            }
+        }
+    }
+
+    // POINTS SHADE COUNT ARBITRARY PIXELS OF A TILE WHOSE TOP LEFT IS X0, Y0 INTO ROWS.
+
+    template<typename S>
+    inline void points(uint32_t* rows, int pitch, S shade, const int* xs, const int* ys, int count, int x0, int y0, V2 zoom)
+    {
+        if constexpr(!packet<S>)
+        {
+            for(int i = 0; i < count; i++)
+                rows[(ys[i] - y0) * pitch + xs[i] - x0] = argb(shade(V2 { (xs[i] + 0.5f) * zoom.x - 0.5f, (ys[i] + 0.5f) * zoom.y - 0.5f }));
+        }
+        else
+        {
+            // GATHERS SCATTERED PIXELS INTO FULL PACKETS. THE LAST PACKET REPEATS ITS FINAL PIXEL IN THE SPARE LANES.
+            for(int at = 0; at < count; at += lanes)
+            {
+                auto u = Vf<lanes> {};
+                auto v = Vf<lanes> {};
+                for(int i = 0; i < lanes; i++)
+                {
+                    const auto k = std::min(at + i, count - 1);
+                    u[i] = float(xs[k]);
+                    v[i] = float(ys[k]);
+                }
+                const auto color = argb(shade(V2p<lanes> { (u + 0.5f) * zoom.x - 0.5f, (v + 0.5f) * zoom.y - 0.5f }));
+                for(int i = 0, n = std::min(lanes, count - at); i < n; i++)
+                    rows[(ys[at + i] - y0) * pitch + xs[at + i] - x0] = color[i];
+            }
+        }
+    }
+
+    class Coarse
+    {
+        // SHADES THE CORNERS OF SIZE * SIZE BLOCKS, THEN SPLITS EVERY BLOCK WHOSE CORNER COLORS VARY BY MORE THAN ERROR
+        // SQUARED IN ANY CHANNEL INTO QUARTERS, SHADING ONLY THE NEW CORNERS, UNTIL BLOCKS ARE ONE PIXEL ACROSS. SETTLED
+        // BLOCKS ARE FILLED BILINEARLY FROM THEIR CORNERS. EACH LEVEL OF A TILE IS SHADED AS ONE BATCH SO PACKETS STAY FULL.
+        struct Block
+        {
+            int xa {};
+            int ya {};
+            int xb {};
+            int yb {};
+        };
+
+        struct alignas(64) Work
+        {
+            std::vector<uint8_t> done {};
+            std::vector<int> xs {};
+            std::vector<int> ys {};
+            std::vector<Block> blocks {};
+            std::vector<Block> split {};
+            uint64_t shaded {};
+        };
+
+        std::vector<Work> works {};
+
+        static int variance(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+        {
+            // THE LARGEST VARIANCE OF THE FOUR CORNERS OVER THE CHANNELS, TIMES 16 SO IT STAYS IN INTEGERS.
+            auto worst = 0;
+            for(int shift = 0; shift < 24; shift += 8)
+            {
+                const auto p = int(a >> shift & 0xFF);
+                const auto q = int(b >> shift & 0xFF);
+                const auto r = int(c >> shift & 0xFF);
+                const auto s = int(d >> shift & 0xFF);
+                const auto sum = p + q + r + s;
+                worst = std::max(worst, 4 * (p * p + q * q + r * r + s * s) - sum * sum);
+            }
+            return worst;
+        }
+
+    public:
+        const int size {};
+        const int error {};
+        // SHARE OF THE LAST FRAME'S PIXELS THAT WERE SHADED. STAYS NEGATIVE WHEN DISABLED.
+        float fraction { -1.f };
+        Coarse(int workers, int size, int error)
+            : works(workers)
+            , size { std::max(1, size) }
+            , error { error }
+        {
+        }
+
+        bool enabled() const
+        {
+            return size > 1;
+        }
+
+        void tally(int pixels)
+        {
+            if(!enabled())
+                return;
+            auto shaded = uint64_t {};
+            for(auto& work : works)
+            {
+                shaded += work.shaded;
+                work.shaded = 0;
+            }
+            fraction = float(double(shaded) / pixels);
+        }
+
+        template<typename S>
+        void operator()(int worker, uint32_t* rows, int pitch, S shade, Tile tile, V2 zoom)
+        {
+            auto& w = works[worker];
+            const auto width = tile.x1 - tile.x0;
+            w.done.assign(width * (tile.y1 - tile.y0), 0);
+            const auto at = [&](int x, int y) { return (y - tile.y0) * width + x - tile.x0; };
+            const auto get = [&](int x, int y) { return rows[(y - tile.y0) * pitch + x - tile.x0]; };
+            const auto mark = [&](int x, int y) {
+                auto& done = w.done[at(x, y)];
+                if(done)
+                    return;
+                done = 1;
+                w.xs.push_back(x);
+                w.ys.push_back(y);
+            };
+            const auto grid = [&](int a, int b) {
+                auto cuts = std::vector<int> {};
+                for(int i = a; i < b - 1; i += size)
+                    cuts.push_back(i);
+                cuts.push_back(b - 1);
+                if(cuts.size() == 1)
+                    cuts.push_back(b - 1);
+                return cuts;
+            };
+            const auto gx = grid(tile.x0, tile.x1);
+            const auto gy = grid(tile.y0, tile.y1);
+            w.blocks.clear();
+            for(size_t j = 0; j + 1 < gy.size(); j++)
+                for(size_t i = 0; i + 1 < gx.size(); i++)
+                {
+                    mark(gx[i], gy[j]);
+                    mark(gx[i + 1], gy[j]);
+                    mark(gx[i], gy[j + 1]);
+                    mark(gx[i + 1], gy[j + 1]);
+                    w.blocks.push_back(Block { gx[i], gy[j], gx[i + 1], gy[j + 1] });
+                }
+            while(!w.blocks.empty())
+            {
+                points(rows, pitch, shade, w.xs.data(), w.ys.data(), int(w.xs.size()), tile.x0, tile.y0, zoom);
+                w.shaded += w.xs.size();
+                w.xs.clear();
+                w.ys.clear();
+                w.split.clear();
+                for(const auto& b : w.blocks)
+                {
+                    if(b.xb - b.xa <= 1 && b.yb - b.ya <= 1)
+                        continue;
+                    const auto c00 = get(b.xa, b.ya);
+                    const auto c10 = get(b.xb, b.ya);
+                    const auto c01 = get(b.xa, b.yb);
+                    const auto c11 = get(b.xb, b.yb);
+                    if(variance(c00, c10, c01, c11) <= 16 * error * error)
+                    {
+                        for(int y = b.ya; y <= b.yb; y++)
+                        {
+                            const auto wy = b.yb == b.ya ? 0u : uint32_t(256 * (y - b.ya) / (b.yb - b.ya));
+                            for(int x = b.xa; x <= b.xb; x++)
+                                if(!w.done[at(x, y)])
+                                {
+                                    const auto wx = b.xb == b.xa ? 0u : uint32_t(256 * (x - b.xa) / (b.xb - b.xa));
+                                    rows[(y - tile.y0) * pitch + x - tile.x0] = blend(blend(c00, c10, wx), blend(c01, c11, wx), wy);
+                                }
+                        }
+                        continue;
+                    }
+                    const auto mx = (b.xa + b.xb) / 2;
+                    const auto my = (b.ya + b.yb) / 2;
+                    mark(mx, b.ya);
+                    mark(mx, b.yb);
+                    mark(b.xa, my);
+                    mark(b.xb, my);
+                    mark(mx, my);
+                    const auto sx = b.xb - b.xa > 1;
+                    const auto sy = b.yb - b.ya > 1;
+                    w.split.push_back(Block { b.xa, b.ya, sx ? mx : b.xb, sy ? my : b.yb });
+                    if(sx)
+                        w.split.push_back(Block { mx, b.ya, b.xb, sy ? my : b.yb });
+                    if(sy)
+                        w.split.push_back(Block { b.xa, my, sx ? mx : b.xb, b.yb });
+                    if(sx && sy)
+                        w.split.push_back(Block { mx, my, b.xb, b.yb });
+                }
+                std::swap(w.blocks, w.split);
+            }
+        }
+    };
+
+    inline bool plain(const Interleave& interleave, const Coarse& coarse, const Samples& samples)
+    {
+        // PLANAR SHADERS ON PLAIN FRAMES SHADE A FLOAT TILE FOR THE PACK STAGE. COARSE, INTERLEAVED AND SUPERSAMPLED
+        // FRAMES PACK EACH PACKET AS IT IS SHADED.
+        return !coarse.enabled() && !interleave.enabled() && samples.count() == 1;
+    }
+
+    template<typename S>
+    struct Needle
+    {
+        Vram& vram;
+        Interleave& interleave;
+        Coarse& coarse;
+        const Samples& samples;
+        const int worker {};
+        const S shade {};
+        const Tiler& tiler;
+        const Tile tile {};
+        uint32_t* const rows {};
+        const int pitch {};
+        const V2 zoom {};
+        Needle(Vram& vram, Interleave& interleave, Coarse& coarse, const Samples& samples, int worker, S shade, const Tiler& tiler, int t, V2 zoom = V2 { 1.f })
+            : vram { vram }
+            , interleave { interleave }
+            , coarse { coarse }
+            , samples { samples }
+            , worker { worker }
+            , shade { shade }
+            , tiler { tiler }
+            , tile { tiler.tiles[t] }
+            , rows { tiler.rows(worker) }
+            , pitch { tiler.pitch }
+            , zoom { zoom }
+        {
+        }
+        bool packs() const
+        {
+            return planar<S> && plain(interleave, coarse, samples);
+        }
+        void operator()()
+        {
+            if(coarse.enabled())
+            {
+                coarse(worker, rows, pitch, shade, tile, zoom);
+                return;
+            }
+            if constexpr(planar<S>)
+                if(packs())
+                {
+                    for(int y = tile.y0; y < tile.y1; y++)
+                        span(tiler.floats(worker) + (y - tile.y0) * pitch, tiler.plane, shade, tile.x0, tile.x1, y, zoom);
+                    return;
+                }
+            if(!interleave.enabled())
+            {
+                for(int y = tile.y0; y < tile.y1; y++)
+                    span(rows + (y - tile.y0) * pitch, shade, tile.x0, tile.x1, y, zoom, tile.x0, 1, samples);
+                return;
+            }
+            const auto step = interleave.step();
+            for(int y = tile.y0; y < tile.y1; y++)
+            {
+                const auto row = rows + (y - tile.y0) * pitch;
+                const auto first = interleave.first(tile.x0, y);
+                span(row, shade, tile.x0, tile.x1, y, zoom, first, step, samples);
+                if(step > 1)
+                    for(int x = tile.x0; x < tile.x1; x++)
+                        if((x - first) % step != 0)
+                            row[x - tile.x0] = interleave.fill(x, y, zoom);
+                interleave.next().stream(tile.x0, tile.x1, y, row);
+            }
+        }
+        void pack()
+        {
+            tiler.pack(worker, tile, vram);
+        }
+        void flush()
+        {
+            for(int y = tile.y0; y < tile.y1; y++)
+                vram.stream(tile.x0, tile.x1, y, rows + (y - tile.y0) * pitch);
+        }
+    };
+
+    class Adaptive
+    {
+        double cost {};
+
+    public:
+        Vram canvas {};
+        const double budget {};
+        float scale { 1.f };
+        Adaptive(double budget)
+            : budget { budget }
+        {
+            if(enabled())
+                canvas.own(false);
+        }
+
+        bool enabled() const
+        {
+            return budget > 0.0;
+        }
+
+        int width() const
+        {
+            return std::max(lanes, int(xres * scale));
+        }
+
+        int height() const
+        {
+            return std::max(1, int(yres * scale));
+        }
+
+        void update(double seconds)
+        {
+            // TRACKS A MOVING AVERAGE OF SECONDS PER SHADED PIXEL, WHICH DOES NOT JUMP WHEN THE SCALE CHANGES, AND PICKS THE
+            // SCALE WHOSE PIXEL COUNT FITS THE BUDGET. STEPS OF 1/32 KEEP THE CANVAS SIZE FROM CHANGING EVERY FRAME.
+            if(!enabled())
+                return;
+            const auto sample = seconds / (double(width()) * height());
+            cost = cost == 0.0 ? sample : cost * 0.9 + sample * 0.1;
+            const auto fit = std::sqrt(budget / (cost * xres * yres));
+            scale = clamp(std::floor(float(fit) * 32.f) / 32.f, 0.25f, 1.f);
+        }
+    };
+
+    template<typename F>
+    double timed(F f)
+    {
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        f();
+        const auto t1 = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0).count();
+    }
+
+    inline void upscale(const Vram& canvas, Vram& vram, int w, int h, int y0, int y1)
+    {
+        // BILINEAR UPSCALE OF THE W * H CORNER OF THE CANVAS TO THE FULL FRAME.
+        const auto sx = float(w) / xres;
+        const auto sy = float(h) / yres;
+        auto row = std::vector<uint32_t>(xres);
+        for(int y = y0; y < y1; y++)
+        {
+            const auto v = clamp((y + 0.5f) * sy - 0.5f, 0.f, h - 1.f);
+            const auto j0 = int(v);
+            const auto j1 = std::min(j0 + 1, h - 1);
+            const auto wy = uint32_t((v - j0) * 256.f);
+            for(int x = 0; x < xres; x++)
+            {
+                const auto u = clamp((x + 0.5f) * sx - 0.5f, 0.f, w - 1.f);
+                const auto i0 = int(u);
+                const auto i1 = std::min(i0 + 1, w - 1);
+                const auto wx = uint32_t((u - i0) * 256.f);
+                const auto top = blend(canvas.get(i0, j0), canvas.get(i1, j0), wx);
+                const auto bot = blend(canvas.get(i0, j1), canvas.get(i1, j1), wx);
+                row[x] = blend(top, bot, wy);
+            }
+            vram.stream(0, xres, y, row.data());
+        }
+    }
+
+    // PER PIXEL STATE OVER THE CANVAS, INDEXED Y * WIDTH + X. G IS BUILT AS G(PIXELS) AND ONLY REBUILT TO GROW. STALE IS
+    // TRUE WHEN THE CANVAS SIZE OR ZOOM CHANGED SINCE THE LAST CALL, WHICH IS WHEN TIME INVARIANT SETUP MUST RERUN.
+
+    template<typename G>
+    class Pixels
+    {
+        std::unique_ptr<G> g {};
+        int pixels {};
+
+    public:
+        int width {};
+        int height {};
+        V2 zoom {};
+        G& get() const
+        {
+            return *g;
+        }
+
+        bool stale(int w, int h, V2 z)
+        {
+            if(w * h > pixels)
+            {
+                g = std::make_unique<G>(w * h);
+                pixels = w * h;
+                width = 0;
+            }
+            if(w == width && h == height && z.x == zoom.x && z.y == zoom.y)
+                return false;
+            width = w;
+            height = h;
+            zoom = z;
+            return true;
+        }
+    };
+
+    inline void indices(int* index, int x, int x1, int y, int width)
+    {
+        for(int i = 0; i < lanes; i++)
+            index[i] = y * width + std::min(x + i, x1 - 1);
+    }
+
+    template<typename F>
+    void packets(const Tile& tile, int width, V2 zoom, F f)
+    {
+        // CALLS F(X, Y, INDEX, COORD) FOR EVERY ROW PACKET OF THE TILE. LANES PAST THE RIGHT EDGE REPEAT THE LAST PIXEL.
+        const auto ramp = Vf<lanes>::ramp();
+        for(int y = tile.y0; y < tile.y1; y++)
+        {
+            const auto v = (y + 0.5f) * zoom.y - 0.5f;
+            for(int x = tile.x0; x < tile.x1; x += lanes)
+            {
+                int index[lanes];
+                indices(index, x, tile.x1, y, width);
+                const auto u = min(ramp + float(x), float(tile.x1 - 1));
+                f(x, y, index, V2p<lanes> { (u + 0.5f) * zoom.x - 0.5f, v });
+            }
+        }
+    }
+
+    template<typename F>
+    void sweep(Pool& pool, Tiler& tiler, V2 zoom, F f)
+    {
+        tiler.reset();
+        pool.dispatch([&](const int i) {
+            for(int t; tiler.next(i, t);)
+            {
+                const auto span = Span { "tile" };
+                packets(tiler.tiles[t], tiler.width, zoom, f);
+            }
+        });
+    }
+
+    template<typename F>
+    void paint(Pool& pool, Vram& vram, Tiler& tiler, V2 zoom, F color)
+    {
+        // FLOAT COLORS GO THROUGH THE WORKER'S FLOAT TILE AND THE PACK STAGE.
+        constexpr auto floats = std::is_same_v<std::invoke_result_t<F&, const int*, V2p<lanes>>, V3p<lanes>>;
+        vram.planar = floats;
+        tiler.reset();
+        pool.dispatch([&](const int i) {
+            const auto rows = tiler.rows(i);
+            const auto r = tiler.floats(i);
+            for(int t; tiler.next(i, t);)
+            {
+                const auto span = Span { "tile" };
+                const auto& tile = tiler.tiles[t];
+                packets(tile, tiler.width, zoom, [&](int x, int y, const int* index, V2p<lanes> coord) {
+                    const auto c = color(index, coord);
+                    const auto at = (y - tile.y0) * tiler.pitch + (x - tile.x0);
+                    if constexpr(floats)
+                    {
+                        std::memcpy(r + at, &c.x.v, sizeof(c.x.v));
+                        std::memcpy(r + at + tiler.plane, &c.y.v, sizeof(c.y.v));
+                        std::memcpy(r + at + tiler.plane * 2, &c.z.v, sizeof(c.z.v));
+                    }
+                    else
+                        std::memcpy(rows + at, &c, sizeof(c));
+                });
+                if constexpr(floats)
+                    pool.packed[i] += timed([&] {
+                        const auto span = Span { "pack" };
+                        tiler.pack(i, tile, vram);
+                    });
+                pool.flushed[i] += timed([&] {
+                    const auto span = Span { "flush" };
+                    for(int y = tile.y0; y < tile.y1; y++)
+                        vram.stream(tile.x0, tile.x1, y, rows + (y - tile.y0) * tiler.pitch);
+                });
+            }
+            vram.fence();
+        });
+    }
+
+    // PACKET SHADERS WITH PER PIXEL, TIME INVARIANT SETUP. SETUP FILLS C, BUILT AS C(PIXELS), ONCE PER CANVAS SIZE AND
+    // ZOOM, SO AGAIN ONLY AFTER A RESIZE OR AN ADAPTIVE SCALE STEP. SHADE READS IT EVERY FRAME AT THE Y * WIDTH + X
+    // INDICES OF ITS LANES. EACH COORD IS MAPPED BACK TO THE CANVAS PIXEL HOLDING IT, SO INTERLEAVING AND COARSE
+    // SHADING WORK AS FOR ANY PACK, AND SUPERSAMPLES SHARE THEIR PIXEL'S CACHED VALUES. SHADE RETURNS A PACKED COLOR,
+    // OR A FLOAT ONE WHEN R IS V3P<LANES>.
+
+    template<typename C, typename R = Vu<lanes>>
+    class Cached
+    {
+    public:
+        using Setup = void (*)(C& c, const int* index, const V2p<lanes> coord, const Uniforms& u);
+        using Shade = R (*)(const C& c, const int* index, const V2p<lanes> coord, const Uniforms& u);
+        std::shared_ptr<Pixels<C>> cache { std::make_shared<Pixels<C>>() };
+        Setup setup {};
+        Shade shade {};
+        Cached(Setup setup, Shade shade)
+            : setup { setup }
+            , shade { shade }
+        {
+        }
+
+        R operator()(const V2p<lanes> coord, const Uniforms& uniforms) const
+        {
+            const auto& p = *cache;
+            const auto u = clamp(floor((coord.x + 0.5f) / p.zoom.x), 0.f, float(p.width - 1));
+            const auto v = clamp(floor((coord.y + 0.5f) / p.zoom.y), 0.f, float(p.height - 1));
+            // THE INDEX IS FORMED IN INT32 LANES, AS FLOAT STOPS HOLDING EVERY INTEGER PAST 2^24 PIXELS, EG. AT 8K.
+            using Raw = typename Mf<lanes>::Raw;
+            const auto k = __builtin_convertvector(v.v, Raw) * p.width + __builtin_convertvector(u.v, Raw);
+            int index[lanes];
+            std::memcpy(index, &k, sizeof(index));
+            return shade(p.get(), index, coord, uniforms);
+        }
+    };
+
+    template<typename S>
+    void prepare(Pool&, Tiler&, S, V2)
+    {
+    }
+
+    template<typename C, typename R>
+    void prepare(Pool& pool, Tiler& tiler, Cached<C, R> shade, V2 zoom)
+    {
+        const auto u = uniforms();
+        if(shade.cache->stale(tiler.width, tiler.height, zoom))
+            sweep(pool, tiler, zoom, [&](int, int, const int* index, V2p<lanes> coord) { shade.setup(shade.cache->get(), index, coord, u); });
+    }
+
+    template<typename S>
+    void needles(Pool& pool, Vram& vram, Tiler& tiler, S shade, Interleave& interleave, Coarse& coarse, const Samples& samples, V2 zoom)
+    {
+        const auto bound = Bound<S> { shade, uniforms() };
+        vram.planar = planar<Bound<S>> && plain(interleave, coarse, samples);
+        tiler.reset();
+        interleave.begin(tiler.width, tiler.height);
+        pool.dispatch([&](const int i) {
+            // MULTITHREADS RENDER WITH WORK STEALING TILES SO CHEAP SKY ROWS DO NOT LEAVE CORES IDLE.
+            for(int t; tiler.next(i, t);)
+            {
+                const auto span = Span { "tile" };
+                auto needle = Needle { vram, interleave, coarse, samples, i, bound, tiler, t, zoom };
+                needle();
+                if(needle.packs())
+                    pool.packed[i] += timed([&] {
+                        const auto span = Span { "pack" };
+                        needle.pack();
+                    });
+                pool.flushed[i] += timed([&] {
+                    const auto span = Span { "flush" };
+                    needle.flush();
+                });
+            }
+            vram.fence();
+        });
+        coarse.tally(tiler.width * tiler.height);
+    }
+
+    template<typename S>
+    void draw(Pool& pool, Vram& vram, Tiler& tiler, S shade, Interleave& interleave, Coarse& coarse, const Samples& samples, V2 zoom = V2 { 1.f })
+    {
+        prepare(pool, tiler, shade, zoom);
+        needles(pool, vram, tiler, shade, interleave, coarse, samples, zoom);
+    }
+
+    // MULTI PASS SHADERS OVER A PER PIXEL G-BUFFER G, WHICH IS BUILT ONCE AS G(PIXELS). EVERY CALL GETS A PACKET OF
+    // G-BUFFER INDICES (Y * WIDTH + X) AND THEIR COORDS:
+    //
+    //     setup      OPTIONAL, RUNS OVER EVERY PIXEL ONCE PER CANVAS SIZE AND ZOOM FOR TIME INVARIANT DATA, AS FOR CACHED
+    //     split      RUNS OVER EVERY PIXEL AND RETURNS THE LANES THAT NEED THE PASSES
+    //     passes     RUN IN ORDER OVER THE COMPACTED LIST OF THOSE PIXELS ONLY, EACH AS ITS OWN PARALLEL STAGE
+    //     resolve    RUNS OVER EVERY PIXEL AND RETURNS ITS COLOR, PACKED OR, WHEN R IS V3P<LANES>, FLOAT
+    //
+    // LANES PAST THE END OF A ROW OR LIST REPEAT THE LAST INDEX, SO PASSES NEVER NEED A MASK. A PASS MAY ONLY WRITE
+    // THE G-BUFFER AT ITS OWN INDICES. INTERLEAVED, COARSE AND SUPERSAMPLED FRAMES SHADE PIXELS AND SAMPLES OUT OF ORDER,
+    // SO THERE EACH PACKET RUNS EVERY STAGE BY ITSELF, WITHOUT THE COMPACTION.
+
+    template<typename G, typename R = Vu<lanes>>
+    class Deferred
+    {
+    public:
+        using Split = Mf<lanes> (*)(G& g, const int* index, const V2p<lanes> coord, const Uniforms& u);
+        using Pass = void (*)(G& g, const int* index, const V2p<lanes> coord, const Uniforms& u);
+        using Resolve = R (*)(G& g, const int* index, const V2p<lanes> coord, const Uniforms& u);
+
+    private:
+        struct State
+        {
+            Pixels<G> pixels {};
+            // THE SPLIT WRITES EACH TILE'S LIVE PIXELS AT THAT TILE'S OFFSET, THEN THE RUNS ARE PACKED TO THE FRONT.
+            std::vector<int> list {};
+            std::vector<int> counts {};
+            int live {};
+            std::atomic<int> next {};
+        };
+        std::shared_ptr<State> state { std::make_shared<State>() };
+
+    public:
+        Pass setup {};
+        Split split {};
+        std::vector<Pass> passes {};
+        Resolve resolve {};
+        Deferred(Split split, std::initializer_list<Pass> passes, Resolve resolve)
+            : split { split }
+            , passes { passes }
+            , resolve { resolve }
+        {
+        }
+
+        Deferred(Pass setup, Split split, std::initializer_list<Pass> passes, Resolve resolve)
+            : setup { setup }
+            , split { split }
+            , passes { passes }
+            , resolve { resolve }
+        {
+        }
+
+        G& buffer() const
+        {
+            return state->pixels.get();
+        }
+
+        R operator()(const V2p<lanes> coord, const Uniforms& u) const
+        {
+            // ONE PACKET ON A PRIVATE G-BUFFER OF LANES PIXELS, SO NO WORKER TOUCHES A PIXEL ANOTHER IS SHADING. SETUP RUNS
+            // AT THE PACKET'S OWN COORDS, WHICH GIVES SUPERSAMPLES THEIR OWN TIME INVARIANT DATA. THE PASSES ARE SKIPPED
+            // WHEN NO LANE IS SPLIT INTO THEM.
+            thread_local auto scratch = std::make_unique<G>(lanes);
+            auto& g = *scratch;
+            int index[lanes];
+            for(int i = 0; i < lanes; i++)
+                index[i] = i;
+            if(setup)
+                setup(g, index, coord, u);
+            if(any(split(g, index, coord, u)))
+                for(const auto pass : passes)
+                    pass(g, index, coord, u);
+            return resolve(g, index, coord, u);
+        }
+
+        bool begin(int width, int height, V2 zoom, int tiles)
+        {
+            state->list.resize(std::max(state->list.size(), size_t(width * height + lanes)));
+            state->counts.resize(tiles);
+            return state->pixels.stale(width, height, zoom);
+        }
+
+        int* list(int offset) const
+        {
+            return state->list.data() + offset;
+        }
+
+        void keep(int tile, int count)
+        {
+            state->counts[tile] = count;
+        }
+
+        int compact(const std::vector<Tile>& tiles)
+        {
+            auto& s = *state;
+            s.live = 0;
+            auto offset = 0;
+            for(size_t t = 0; t < tiles.size(); t++)
+            {
+                std::memmove(list(s.live), list(offset), sizeof(int) * s.counts[t]);
+                s.live += s.counts[t];
+                offset += (tiles[t].x1 - tiles[t].x0) * (tiles[t].y1 - tiles[t].y0);
+            }
+            std::fill(list(s.live), list(s.live + lanes), s.live > 0 ? s.list[s.live - 1] : 0);
+            s.next = 0;
+            return s.live;
+        }
+
+        bool claim(int chunk, int& start, int& end)
+        {
+            auto& s = *state;
+            start = s.next.fetch_add(chunk);
+            end = std::min(start + chunk, s.live);
+            return start < s.live;
+        }
+
+        void rewind()
+        {
+            state->next = 0;
+        }
+    };
+
+    inline V2p<lanes> locate(const int* index, int width, V2 zoom)
+    {
+        auto x = Vf<lanes> {};
+        auto y = Vf<lanes> {};
+        for(int i = 0; i < lanes; i++)
+        {
+            x.v[i] = float(index[i] % width);
+            y.v[i] = float(index[i] / width);
+        }
+        return V2p<lanes> { (x + 0.5f) * zoom.x - 0.5f, (y + 0.5f) * zoom.y - 0.5f };
+    }
+
+    template<typename G, typename R>
+    void draw(Pool& pool, Vram& vram, Tiler& tiler, Deferred<G, R> shade, Interleave& interleave, Coarse& coarse, const Samples& samples, V2 zoom = V2 { 1.f })
+    {
+        if(interleave.enabled() || coarse.enabled() || samples.count() > 1)
+        {
+            needles(pool, vram, tiler, shade, interleave, coarse, samples, zoom);
+            return;
+        }
+        const auto w = tiler.width;
+        auto offsets = std::vector<int>(tiler.tiles.size());
+        for(size_t t = 1; t < offsets.size(); t++)
+        {
+            const auto& tile = tiler.tiles[t - 1];
+            offsets[t] = offsets[t - 1] + (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+        }
+        const auto stale = shade.begin(w, tiler.height, zoom, int(tiler.tiles.size()));
+        const auto u = uniforms();
+        auto& g = shade.buffer();
+        if(stale && shade.setup)
+            sweep(pool, tiler, zoom, [&](int, int, const int* index, V2p<lanes> coord) { shade.setup(g, index, coord, u); });
+        tiler.reset();
+        pool.dispatch([&](const int i) {
+            for(int t; tiler.next(i, t);)
+            {
+                const auto span = Span { "tile" };
+                const auto& tile = tiler.tiles[t];
+                const auto list = shade.list(offsets[t]);
+                auto count = 0;
+                packets(tile, w, zoom, [&](int x, int, const int* index, V2p<lanes> coord) {
+                    const auto live = shade.split(g, index, coord, u);
+                    for(int l = 0; l < lanes && x + l < tile.x1; l++)
+                        if(live.v[l])
+                            list[count++] = index[l];
+                });
+                shade.keep(t, count);
+            }
+        });
+        shade.compact(tiler.tiles);
+        for(const auto pass : shade.passes)
+        {
+            // CHUNKS ARE WHOLE PACKETS SO NO TWO WORKERS EVER WRITE THE SAME PIXEL.
+            pool.dispatch([&](const int) {
+                for(int start, end; shade.claim(16 * lanes, start, end);)
+                {
+                    const auto span = Span { "pass" };
+                    for(int k = start; k < end; k += lanes)
+                        pass(g, shade.list(k), locate(shade.list(k), w, zoom), u);
+                }
+            });
+            shade.rewind();
+        }
+        paint(pool, vram, tiler, zoom, [&](const int* index, V2p<lanes> coord) { return shade.resolve(g, index, coord, u); });
+    }
+
+    template<typename S>
+    void draw(Pool& pool, Vram& vram, Tiler& tiler, S shade, Interleave& interleave, Coarse& coarse, const Samples& samples, Adaptive& adaptive)
+    {
+        const auto w = adaptive.width();
+        const auto h = adaptive.height();
+        tiler.cut(w, h);
+        if(w == xres && h == yres)
+        {
+            draw(pool, vram, tiler, shade, interleave, coarse, samples);
+            return;
+        }
+        draw(pool, adaptive.canvas, tiler, shade, interleave, coarse, samples, V2 { float(xres) / w, float(yres) / h });
+        pool.dispatch([&](const int i) {
+            const auto span = Span { "upscale" };
+            upscale(adaptive.canvas, vram, w, h, yres * i / pool.size, yres * (i + 1) / pool.size);
+            vram.fence();
+        });
+        vram.planar = false;
+    }
+
+    inline void report(double dt, const Adaptive& adaptive, float scale, float shaded, double latency = -1.0)
+    {
+        std::printf("draw fps: %f", 1.0 / dt);
+        if(adaptive.enabled())
+            std::printf(" scale: %.3f", double(scale));
+        if(shaded >= 0.f)
+            std::printf(" shaded: %.3f", double(shaded));
+        if(latency >= 0.0)
+            std::printf(" latency: %.3f ms", 1e3 * latency);
+        std::printf("\n");
+    }
+
+    inline double percentile(std::vector<double> times, double p)
+    {
+        std::sort(times.begin(), times.end());
+        return times[std::min(times.size() - 1, size_t(p * times.size()))];
+    }
+
+    inline void dump(const Vram& vram, const char* path)
+    {
+        auto frame = std::vector<uint32_t>(xres * yres);
+        for(int y = 0; y < yres; y++)
+            for(int x = 0; x < xres; x++)
+                frame[x + y * xres] = vram.get(x, y);
+        if(const auto file = std::fopen(path, "wb"))
+        {
+            std::fwrite(frame.data(), sizeof(frame[0]), frame.size(), file);
+            std::fclose(file);
+        }
+    }
+
+    inline void compare(const Vram& vram, const char* path)
+    {
+        // DIFFS THE LAST FRAME AGAINST A REFERENCE DUMP, EG. THE SAME SHADER BUILT WITHOUT SS_FAST_MATH.
+        auto frame = std::vector<uint32_t>(xres * yres);
+        const auto file = std::fopen(path, "rb");
+        if(!file || std::fread(frame.data(), sizeof(frame[0]), frame.size(), file) != frame.size())
+        {
+            std::printf(", \"compare\": null");
+            if(file)
+                std::fclose(file);
+            return;
+        }
+        std::fclose(file);
+        auto worst = 0;
+        auto sum = 0.0;
+        for(int y = 0; y < yres; y++)
+            for(int x = 0; x < xres; x++)
+                for(int shift = 0; shift < 24; shift += 8)
+                {
+                    const auto a = int(vram.get(x, y) >> shift & 0xFF);
+                    const auto b = int(frame[x + y * xres] >> shift & 0xFF);
+                    worst = std::max(worst, std::abs(a - b));
+                    sum += std::abs(a - b);
+                }
+        std::printf(", \"compare\": {\"max\": %d, \"mean\": %.4f}", worst, sum / (3.0 * xres * yres));
+    }
+
+    inline const char* mode(const char* name, bool applies)
+    {
+        // READS THE OPTION OF A MODE, AS UNSET WHEN COARSE SHADING OVERRIDES IT, SO REPORTS SHOW WHAT ACTUALLY RAN.
+        const auto value = std::getenv(name);
+        if(value && !applies)
+        {
+            std::fprintf(stderr, "%s does not apply to coarse shading, ignoring it\n", name);
+            return nullptr;
+        }
+        return value;
+    }
+
+    template<typename S>
+    double bench(Pool& pool, Vram& vram, Tiler& tiler, S shade, Interleave& interleave, Coarse& coarse, const Samples& samples, const char* name)
+    {
+        // TIME IS DRIVEN BY THE FRAME INDEX, NOT THE WALL CLOCK, SO EVERY RUN SHADES THE SAME FRAMES.
+        // STATS NEED AT LEAST ONE FRAME.
+        const auto frames = std::max(1, option("SS_FRAMES", 300));
+        pool.reset();
+        const auto fps = option("SS_FPS", 60);
+        auto times = std::vector<double>(frames);
+        auto shaded = 0.0;
+        for(int frame = 0; frame < frames; frame++)
+        {
+            time = float(frame) / float(fps);
+            times[frame] = timed([&] {
+                const auto span = Span { "draw", advance() };
+                draw(pool, vram, tiler, shade, interleave, coarse, samples);
+            });
+            shaded += coarse.enabled() ? double(coarse.fraction) : 1.0;
+        }
+        auto total = 0.0;
+        for(auto t : times)
+            total += t;
+        auto flush = 0.0;
+        for(auto t : pool.flushed)
+            flush += t / pool.size;
+        auto pack = 0.0;
+        for(auto t : pool.packed)
+            pack += t / pool.size;
+        std::printf("{\"shader\": \"%s\", \"xres\": %d, \"yres\": %d, \"frames\": %d, \"threads\": %d, \"lanes\": %d, \"interleave\": %d, \"samples\": %d, ", name, xres, yres, frames, pool.size, lanes, interleave.n, samples.count());
+        const auto median = percentile(times, 0.5);
+        std::printf("\"min_ms\": %.3f, \"median_ms\": %.3f, \"p99_ms\": %.3f, ", 1e3 * percentile(times, 0.0), 1e3 * median, 1e3 * percentile(times, 0.99));
+        std::printf("\"mpixels_per_s\": %.3f, \"shaded\": %.3f, ", 1e-6 * xres * yres * frames / total, shaded / frames);
+        // FLUSH IS THE PER FRAME TIME SPENT STREAMING SHADED ROWS TO THE FRAMEBUFFER, AVERAGED OVER THREADS.
+        std::printf("\"flush_ms\": %.3f, \"flush_gb_per_s\": %.3f, ", 1e3 * flush / frames, 1e-9 * sizeof(uint32_t) * xres * yres * frames / flush);
+        // PACK IS THE PER FRAME TIME PLANAR SHADERS SPEND PACKING FLOAT TILES, LIKEWISE AVERAGED. IT IS 0 FOR PACKED SHADERS.
+        std::printf("\"pack_ms\": %.3f, \"utilization\": [", 1e3 * pack / frames);
+        for(int i = 0; i < pool.size; i++)
+            std::printf("%s%.3f", i == 0 ? "" : ", ", pool.worked[i] / total);
+        std::printf("]");
+        if(const auto path = std::getenv("SS_DUMP"))
+            dump(vram, path);
+        if(const auto path = std::getenv("SS_COMPARE"))
+            compare(vram, path);
+        std::printf("}\n");
+        return median;
+    }
+
+    template<typename S>
+    void measure(S shade, const char* name, Motion motion = nullptr)
+    {
+        // BENCHES ON A FRESH POOL. SS_SCALING SWEEPS 1, 2, 4 ... WORKERS UP TO THE FULL POOL, PINNED AS SS_PIN SAYS, AND ENDS
+        // WITH ONE LINE OF SPEEDUP AND PARALLEL EFFICIENCY OVER ONE WORKER FOR EACH WORKER COUNT.
+        const auto scaling = option("SS_SCALING", 0) != 0;
+        const auto most = placement().workers;
+        const auto block = option("SS_COARSE", 1);
+        const auto pattern = mode("SS_AA", block <= 1);
+        const auto every = mode("SS_INTERLEAVE", block <= 1) ? option("SS_INTERLEAVE", 1) : 1;
+        auto counts = std::vector<int> {};
+        if(scaling)
+            for(int n = 1; n < most; n *= 2)
+                counts.push_back(n);
+        counts.push_back(most);
+        auto medians = std::vector<double> {};
+        for(auto threads : counts)
+        {
+            auto vram = Vram {};
+            auto pool = Pool { threads };
+            auto tiler = Tiler { pool, option("SS_TILE", 32) };
+            auto coarse = Coarse { threads, block, option("SS_COARSE_ERROR", 4) };
+            const auto samples = Samples { pattern };
+            auto interleave = Interleave { every, motion };
+            vram.own();
+            tiler.place(pool, vram);
+            medians.push_back(bench(pool, vram, tiler, shade, interleave, coarse, samples, name));
+        }
+        if(!scaling)
+            return;
+        const auto pin = std::getenv("SS_PIN");
+        std::printf("{\"shader\": \"%s\", \"pin\": \"%s\", \"scaling\": [", name, pin ? pin : "none");
+        for(size_t i = 0; i < counts.size(); i++)
+        {
+            std::printf("%s{\"threads\": %d, \"cpus\": ", i == 0 ? "" : ", ", counts[i]);
+            if(placement().cpus.empty())
+                std::printf("null");
+            else
+                for(int worker = 0; worker < counts[i]; worker++)
+                    std::printf("%s%d", worker == 0 ? "[" : ", ", placement().cpu(worker));
+            const auto speedup = medians[0] / medians[i];
+            std::printf("%s, \"median_ms\": %.3f, \"speedup\": %.3f, \"efficiency\": %.3f}", placement().cpus.empty() ? "" : "]", 1e3 * medians[i], speedup, speedup / counts[i]);
+        }
+        std::printf("]}\n");
+    }
+
+    struct Frame
+    {
+        Vram vram {};
+        uint32_t id {};
+        std::chrono::high_resolution_clock::time_point start {};
+        double dt {};
+        float scale {};
+        float shaded {};
+    };
+
+    class Chain
+    {
+        // BOUNDED QUEUE OF BACK BUFFERS. THE SHADING THREAD TAKES FREE FRAMES AND SUBMITS THEM SHADED, THE MAIN
+        // THREAD PRESENTS SHADED FRAMES AND RELEASES THEM. SHADING STALLS ONCE EVERY FRAME IS WAITING TO PRESENT.
+        std::mutex mutex {};
+        std::condition_variable changed {};
+        std::deque<int> free {};
+        std::deque<int> ready {};
+        bool closed { false };
+
+        bool take(std::deque<int>& from, int& slot)
+        {
+            auto lock = std::unique_lock<std::mutex> { mutex };
+            changed.wait(lock, [&] { return closed || !from.empty(); });
+            if(closed)
+                return false;
+            slot = from.front();
+            from.pop_front();
+            return true;
+        }
+
+        void give(std::deque<int>& to, int slot)
+        {
+            {
+                auto lock = std::lock_guard<std::mutex> { mutex };
+                to.push_back(slot);
+            }
+            changed.notify_all();
+        }
+
+    public:
+        std::vector<Frame> frames {};
+        Chain(int depth)
+            : frames(depth)
+        {
+            for(int i = 0; i < depth; i++)
+            {
+                frames[i].vram.own();
+                free.push_back(i);
+            }
+        }
+
+        Chain(const Chain&) = delete;
+        Chain& operator=(const Chain&) = delete;
+
+        bool acquire(int& slot)
+        {
+            return take(free, slot);
+        }
+
+        void submit(int slot)
+        {
+            give(ready, slot);
+        }
+
+        bool present(int& slot)
+        {
+            return take(ready, slot);
+        }
+
+        void release(int slot)
+        {
+            give(free, slot);
+        }
+
+        void close()
+        {
+            {
+                auto lock = std::lock_guard<std::mutex> { mutex };
+                closed = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    template<typename S>
+    void pipeline(Pool& pool, Tiler& tiler, S shade, Interleave& interleave, Coarse& coarse, const Samples& samples, Adaptive& adaptive, Video& video, int depth)
+    {
+        // WORKERS SHADE FRAME N + 1 INTO A BACK BUFFER WHILE THE MAIN THREAD UPLOADS AND PRESENTS FRAME N, SO VSYNC
+        // AND THE TEXTURE UPLOAD NO LONGER IDLE THE POOL. SDL RENDER CALLS STAY ON THE MAIN THREAD. THE REPORTED
+        // LATENCY RUNS FROM THE START OF SHADING TO THE END OF PRESENT AND GROWS WITH SS_BUFFERS.
+        auto chain = Chain { depth };
+        for(auto& frame : chain.frames)
+            tiler.place(pool, frame.vram);
+        auto shader = std::thread { [&] {
+            label("shader");
+            for(int slot; chain.acquire(slot);)
+            {
+                auto& frame = chain.frames[slot];
+                tick();
+                frame.id = advance();
+                frame.start = std::chrono::high_resolution_clock::now();
+                frame.scale = adaptive.scale;
+                frame.dt = timed([&] {
+                    const auto span = Span { "draw", frame.id };
+                    draw(pool, frame.vram, tiler, shade, interleave, coarse, samples, adaptive);
+                });
+                frame.shaded = coarse.fraction;
+                adaptive.update(frame.dt);
+                chain.submit(slot);
+            }
+        } };
+        for(auto input = Input {}; !input.done; input.update())
+        {
+            cycle(shade, input.step);
+            int slot;
+            if(!chain.present(slot))
+                break;
+            const auto& frame = chain.frames[slot];
+            const auto id = frame.id;
+            const auto start = frame.start;
+            const auto dt = frame.dt;
+            const auto scale = frame.scale;
+            const auto shaded = frame.shaded;
+            {
+                const auto span = Span { "upload", id };
+                frame.vram.upload(video.texture);
+            }
+            chain.release(slot);
+            {
+                const auto span = Span { "present", id };
+                video.render();
+            }
+            const auto latency = std::chrono::high_resolution_clock::now() - start;
+            report(dt, adaptive, scale, shaded, std::chrono::duration_cast<std::chrono::duration<double>>(latency).count());
+        }
+        chain.close();
+        shader.join();
+    }
+
+    // OFFLINE OUTPUT. PIXELS ARE 0XAARRGGBB. RAW FRAMES ARE RGBA BYTES, Y4M FRAMES ARE 8 BIT BT.601 4:4:4 AND PNG FRAMES
+    // ARE RGB WITH STORED (UNCOMPRESSED) DEFLATE BLOCKS SO NO ZLIB IS NEEDED. RECOMPRESS WITH AN ENCODER DOWNSTREAM.
+
+    inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+    {
+        static const auto table = [] {
+            auto t = std::vector<uint32_t>(256);
+            for(uint32_t n = 0; n < 256; n++)
+            {
+                auto c = n;
+                for(int k = 0; k < 8; k++)
+                    c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for(size_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    inline void big(std::vector<uint8_t>& bytes, uint32_t value)
+    {
+        for(int shift = 24; shift >= 0; shift -= 8)
+            bytes.push_back(uint8_t(value >> shift));
+    }
+
+    inline void chunk(std::vector<uint8_t>& bytes, const char* type, const std::vector<uint8_t>& data)
+    {
+        big(bytes, uint32_t(data.size()));
+        const auto start = bytes.size();
+        bytes.insert(bytes.end(), type, type + 4);
+        bytes.insert(bytes.end(), data.begin(), data.end());
+        big(bytes, crc32(bytes.data() + start, bytes.size() - start));
+    }
+
+    inline void png(const Vram& vram, std::vector<uint8_t>& bytes)
+    {
+        auto scan = std::vector<uint8_t> {};
+        scan.reserve((1 + 3 * vram.width) * vram.height);
+        for(int y = 0; y < vram.height; y++)
+        {
+            scan.push_back(0);
+            for(int x = 0; x < vram.width; x++)
+            {
+                const auto p = vram.get(x, y);
+                scan.insert(scan.end(), { uint8_t(p >> 16), uint8_t(p >> 8), uint8_t(p) });
+            }
+        }
+        auto zlib = std::vector<uint8_t> { 0x78, 0x01 };
+        zlib.reserve(scan.size() + scan.size() / 65535 * 5 + 16);
+        auto a = uint32_t { 1 };
+        auto b = uint32_t { 0 };
+        for(size_t at = 0; at < scan.size() || at == 0; at += 65535)
+        {
+            const auto size = uint16_t(std::min<size_t>(65535, scan.size() - at));
+            zlib.insert(zlib.end(), { uint8_t(at + size == scan.size()), uint8_t(size), uint8_t(size >> 8), uint8_t(~size), uint8_t(~size >> 8) });
+            zlib.insert(zlib.end(), scan.begin() + at, scan.begin() + at + size);
+            for(size_t i = at; i < at + size; i++)
+            {
+                a = (a + scan[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+        }
+        big(zlib, b << 16 | a);
+        auto header = std::vector<uint8_t> {};
+        big(header, uint32_t(vram.width));
+        big(header, uint32_t(vram.height));
+        header.insert(header.end(), { 8, 2, 0, 0, 0 });
+        bytes = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        chunk(bytes, "IHDR", header);
+        chunk(bytes, "IDAT", zlib);
+        chunk(bytes, "IEND", {});
+    }
+
+    inline void y4m(const Vram& vram, std::vector<uint8_t>& bytes)
+    {
+        const auto size = size_t(vram.width) * vram.height;
+        const auto frame = std::string { "FRAME\n" };
+        bytes.assign(frame.begin(), frame.end());
+        bytes.resize(frame.size() + 3 * size);
+        const auto plane = bytes.data() + frame.size();
+        for(int y = 0; y < vram.height; y++)
+            for(int x = 0; x < vram.width; x++)
+            {
+                const auto p = vram.get(x, y);
+                const auto r = int(p >> 16 & 0xFF);
+                const auto g = int(p >> 8 & 0xFF);
+                const auto b = int(p & 0xFF);
+                const auto i = size_t(x) + size_t(y) * vram.width;
+                plane[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                plane[i + size] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                plane[i + size * 2] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+    }
+
+    inline void rgba(const Vram& vram, std::vector<uint8_t>& bytes)
+    {
+        bytes.resize(size_t(4) * vram.width * vram.height);
+        auto out = bytes.data();
+        for(int y = 0; y < vram.height; y++)
+            for(int x = 0; x < vram.width; x++, out += 4)
+            {
+                const auto p = vram.get(x, y);
+                out[0] = uint8_t(p >> 16);
+                out[1] = uint8_t(p >> 8);
+                out[2] = uint8_t(p);
+                out[3] = uint8_t(p >> 24);
+            }
+    }
+
+    inline bool parse(const std::string& name, Format& format)
+    {
+        const std::pair<const char*, Format> formats[] = { { "bgra", Format::bgra }, { "argb", Format::argb }, { "rgb565", Format::rgb565 }, { "rgb10", Format::rgb10 } };
+        for(const auto& [key, value] : formats)
+            if(name == key)
+            {
+                format = value;
+                return true;
+            }
+        return false;
+    }
+
+    inline void raw(const Vram& vram, Format format, bool dither, std::vector<uint8_t>& bytes)
+    {
+        // REPACKS THE FRAME A ROW AT A TIME, FROM ITS FLOAT PLANES IF IT KEPT THEM. OTHERWISE EACH 8 BIT CHANNEL IS WIDENED
+        // TO THE CENTER OF ITS LEVEL, SO BGRA AND ARGB COME BACK UNCHANGED. RGB10 NEEDS THE PLANES TO HOLD MORE THAN 8 BITS,
+        // SO CALLERS ONLY ASK FOR IT FROM DEEP FRAMES. ONLY RGB565, WHICH DROPS BITS, IS DITHERED.
+        const auto padded = (vram.width + lanes - 1) / lanes * lanes;
+        const auto size = size_t(ss::bytes(format)) * vram.width;
+        auto planes = std::vector<float>(3 * padded);
+        const auto r = planes.data();
+        bytes.resize(size * vram.height);
+        for(int y = 0; y < vram.height; y++)
+        {
+            if(vram.deep())
+            {
+                pack(format, vram.floats(y, 0), vram.floats(y, 1), vram.floats(y, 2), vram.width, 0, y, dither && format == Format::rgb565, bytes.data() + size * y);
+                continue;
+            }
+            const auto row = vram.row(y);
+            for(int x = 0; x < padded; x += lanes)
+            {
+                auto p = Vu<lanes> {};
+                std::memcpy(&p, row + x, sizeof(p));
+                for(int c = 0; c < 3; c++)
+                {
+                    const auto level = Vf<lanes> { __builtin_convertvector(p >> (16 - 8 * c) & 0xFF, typename Vf<lanes>::Raw) };
+                    const auto f = (level + 0.5f) * (1.f / 255.f);
+                    std::memcpy(r + c * padded + x, &f.v, sizeof(f.v));
+                }
+            }
+            pack(format, r, r + padded, r + 2 * padded, vram.width, 0, y, dither && format == Format::rgb565, bytes.data() + size * y);
+        }
+    }
+
+    inline bool numbered(const std::string& pattern)
+    {
+        // PNG NAMES ARE PRINTED WITH THE PATTERN AS THE FORMAT, SO IT MAY HOLD ONE %D OR %0ND FOR THE FRAME AND ONLY %% BESIDES.
+        auto conversions = 0;
+        for(size_t i = 0; i < pattern.size(); i++)
+        {
+            if(pattern[i] != '%')
+                continue;
+            if(++i < pattern.size() && pattern[i] == '%')
+                continue;
+            if(i < pattern.size() && pattern[i] == '0')
+                i++;
+            while(i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9')
+                i++;
+            if(i == pattern.size() || pattern[i] != 'd')
+                return false;
+            conversions++;
+        }
+        return conversions == 1;
+    }
+
+    class Writer
+    {
+        // ANY I/O THREAD MAY ENCODE A FRAME, BUT FRAMES ARE WRITTEN STRICTLY IN ORDER SO RAW AND Y4M STREAMS STAY SEQUENTIAL.
+        std::mutex mutex {};
+        std::condition_variable turn {};
+        const std::string format {};
+        const std::string output {};
+        std::FILE* stream {};
+        uint32_t next {};
+        Format packed {};
+        const bool repacks { parse(format, packed) };
+        const bool streamed { format == "raw" || format == "y4m" || repacks };
+        const bool dither { option("SS_DITHER", 0) != 0 };
+
+    public:
+        Writer(const std::string& format, const char* path, int fps)
+            : format { format }
+            , output { path ? path : format == "png" ? "frame%05d.png" : format == "y4m" ? "-" : format == "raw" ? "frames.rgba" : "frames." + format }
+        {
+            if(format == "png")
+            {
+                if(!numbered(output))
+                    std::fprintf(stderr, "render: SS_OUTPUT %s must hold exactly one %%d or %%0Nd\n", output.c_str());
+                return;
+            }
+            // AN UNKNOWN FORMAT IS REJECTED BY OK() BEFORE ANYTHING IS OPENED, SO IT LEAVES NO EMPTY FILE BEHIND.
+            if(!streamed)
+                return;
+            stream = output == "-" ? stdout : std::fopen(output.c_str(), "wb");
+            if(stream && format == "y4m")
+                std::fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", xres, yres, fps);
+        }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        ~Writer()
+        {
+            if(stream && stream != stdout)
+                std::fclose(stream);
+            if(stream == stdout)
+                std::fflush(stdout);
+        }
+
+        bool ok() const
+        {
+            return format == "png" ? numbered(output) : stream != nullptr;
+        }
+
+        void encode(const Vram& vram, std::vector<uint8_t>& bytes) const
+        {
+            if(format == "png")
+                png(vram, bytes);
+            else if(format == "y4m")
+                y4m(vram, bytes);
+            else if(repacks)
+                raw(vram, packed, dither, bytes);
+            else
+                rgba(vram, bytes);
+        }
+
+        void write(uint32_t id, const std::vector<uint8_t>& bytes)
+        {
+            auto lock = std::unique_lock<std::mutex> { mutex };
+            turn.wait(lock, [&] { return next == id; });
+            if(format == "png")
+            {
+                auto name = std::vector<char>(output.size() + 32);
+                std::snprintf(name.data(), name.size(), output.c_str(), int(id));
+                if(const auto file = std::fopen(name.data(), "wb"))
+                {
+                    std::fwrite(bytes.data(), 1, bytes.size(), file);
+                    std::fclose(file);
+                }
+            }
+            else
+                std::fwrite(bytes.data(), 1, bytes.size(), stream);
+            next++;
+            turn.notify_all();
+        }
+
+        void wait(uint32_t frames)
+        {
+            auto lock = std::unique_lock<std::mutex> { mutex };
+            turn.wait(lock, [&] { return next == frames; });
+        }
+    };
+
+    template<typename S>
+    bool floats(const S&)
+    {
+        return planar<Bound<S>>;
+    }
+
+    template<typename S>
+    void render(Pool& pool, Tiler& tiler, S shade, Interleave& interleave, Coarse& coarse, const Samples& samples, const std::string& format)
+    {
+        // RENDERS SS_START TO SS_END MILLISECONDS AT SS_FPS. THE POOL SHADES INTO SS_BUFFERS BACK BUFFERS WHILE SS_WRITERS
+        // I/O THREADS ENCODE AND WRITE THEM, SO SHADING ONLY WAITS WHEN EVERY BACK BUFFER IS STILL QUEUED FOR I/O.
+        const auto fps = option("SS_FPS", 60);
+        const auto start = option("SS_START", 0);
+        const auto frames = std::max(0, (option("SS_END", 5000) - start) * fps / 1000);
+        // RGB10 PACKS THE FLOAT COLORS EACH FRAME KEEPS, SO IT NEEDS A PLANAR SHADER ON PLAIN FRAMES.
+        auto packed = Format {};
+        const auto deep = parse(format, packed) && packed == Format::rgb10;
+        if(deep && !(floats(shade) && plain(interleave, coarse, samples)))
+        {
+            std::fprintf(stderr, "render: rgb10 needs float colors, without SS_AA, SS_INTERLEAVE or SS_COARSE\n");
+            return;
+        }
+        auto writer = Writer { format, std::getenv("SS_OUTPUT"), fps };
+        if(!writer.ok())
+        {
+            std::fprintf(stderr, "render: cannot write %s output\n", format.c_str());
+            return;
+        }
+        auto chain = Chain { std::max(1, option("SS_BUFFERS", 4)) };
+        for(auto& frame : chain.frames)
+        {
+            frame.vram.deepen(deep);
+            tiler.place(pool, frame.vram);
+        }
+        auto writers = std::vector<std::thread> {};
+        for(int i = 0; i < std::max(1, option("SS_WRITERS", 2)); i++)
+            writers.push_back(std::thread { [&, i] {
+                label("writer", i);
+                auto bytes = std::vector<uint8_t> {};
+                for(int slot; chain.present(slot);)
+                {
+                    const auto id = chain.frames[slot].id;
+                    {
+                        const auto span = Span { "encode", id };
+                        writer.encode(chain.frames[slot].vram, bytes);
+                    }
+                    chain.release(slot);
+                    const auto span = Span { "write", id };
+                    writer.write(id, bytes);
+                }
+            } });
+        const auto seconds = timed([&] {
+            for(int frame = 0, slot; frame < frames && chain.acquire(slot); frame++)
+            {
+                auto& back = chain.frames[slot];
+                back.id = uint32_t(frame);
+                time = start * 0.001f + float(frame) / float(fps);
+                {
+                    const auto span = Span { "draw", advance() };
+                    draw(pool, back.vram, tiler, shade, interleave, coarse, samples);
+                }
+                chain.submit(slot);
+            }
+            writer.wait(uint32_t(frames));
+        });
+        chain.close();
+        for(auto& thread : writers)
+            thread.join();
+        std::fprintf(stderr, "render: %d frames of %dx%d %s in %.3f s (%.3f fps)\n", frames, xres, yres, format.c_str(), seconds, frames / seconds);
+    }
+
+    struct Job
+    {
+        uint32_t id {};
+        std::string shader {};
+        float time {};
+        int width {};
+        int height {};
+        int priority {};
+        int fps {};
+        std::string stream {};
+        std::string output {};
+        std::chrono::high_resolution_clock::time_point queued {};
+        double dt {};
+    };
+
+    inline std::string escaped(const std::string& text)
+    {
+        // JOB FIELDS ARE USER TEXT, SO QUOTES, BACKSLASHES AND CONTROL CHARACTERS ARE ESCAPED BEFORE THEY GO INTO A JSON REPLY.
+        auto out = std::string {};
+        for(const auto c : text)
+        {
+            if(c == '"' || c == '\\')
+                out += '\\';
+            if(uint8_t(c) < 0x20)
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", unsigned(c));
+                out += code;
+            }
+            else
+                out += c;
+        }
+        return out;
+    }
+
+    inline bool parse(const char* line, uint32_t id, Job& job)
+    {
+        // <SHADER> <TIME MS> <WIDTH> <HEIGHT> [PRIORITY=N] [FPS=N] [STREAM=NAME] [OUTPUT=PATH]. STREAM DEFAULTS TO THE SHADER
+        // NAME AND FPS, WHICH ONLY GOES INTO Y4M HEADERS, TO SS_FPS AS FOR OFFLINE RENDERS.
+        char name[256];
+        auto ms = 0.f;
+        auto used = 0;
+        if(std::sscanf(line, "%255s %f %d %d%n", name, &ms, &job.width, &job.height, &used) != 4)
+            return false;
+        job.id = id;
+        job.shader = name;
+        job.time = ms * 1e-3f;
+        job.priority = 0;
+        job.fps = option("SS_FPS", 60);
+        job.stream = name;
+        job.output = job.shader + "-" + std::to_string(id) + ".png";
+        auto n = 0;
+        for(auto rest = line + used; std::sscanf(rest, "%255s%n", name, &n) == 1; rest += n)
+        {
+            const auto token = std::string { name };
+            const auto eq = token.find('=');
+            if(eq == std::string::npos)
+                return false;
+            const auto key = token.substr(0, eq);
+            const auto value = token.substr(eq + 1);
+            if(key == "priority")
+                job.priority = std::atoi(value.c_str());
+            else if(key == "fps" && std::atoi(value.c_str()) > 0)
+                job.fps = std::atoi(value.c_str());
+            else if(key == "stream")
+                job.stream = value;
+            else if(key == "output")
+                job.output = value;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    class Jobs
+    {
+        // FAIR SCHEDULING SERVES THE STREAM WITH THE FEWEST FRAMES SHADED SO FAR, PRIORITY SCHEDULING THE HIGHEST PRIORITY.
+        // TIES GO TO THE OLDEST JOB. A STREAM THAT GOES IDLE RESUMES AT THE CURRENT SERVICE COUNT RATHER THAN ITS OLD ONE,
+        // SO IT CANNOT BANK CREDIT AND THEN MONOPOLIZE THE POOL.
+        std::mutex mutex {};
+        std::condition_variable changed {};
+        std::vector<Job> pending {};
+        std::map<std::string, uint64_t> served {};
+        uint64_t clock {};
+        bool closed { false };
+        const bool fair {};
+
+        bool before(const Job& a, const Job& b)
+        {
+            if(fair && served[a.stream] != served[b.stream])
+                return served[a.stream] < served[b.stream];
+            if(!fair && a.priority != b.priority)
+                return a.priority > b.priority;
+            return a.id < b.id;
+        }
+
+    public:
+        Jobs(bool fair)
+            : fair { fair }
+        {
+        }
+
+        void push(Job job)
+        {
+            {
+                auto lock = std::lock_guard<std::mutex> { mutex };
+                const auto idle = std::none_of(pending.begin(), pending.end(), [&](const Job& other) { return other.stream == job.stream; });
+                if(idle)
+                    served[job.stream] = std::max(served[job.stream], clock);
+                pending.push_back(std::move(job));
+            }
+            changed.notify_all();
+        }
+
+        bool pop(Job& job)
+        {
+            auto lock = std::unique_lock<std::mutex> { mutex };
+            changed.wait(lock, [&] { return closed || !pending.empty(); });
+            if(pending.empty())
+                return false;
+            auto best = pending.begin();
+            for(auto it = pending.begin() + 1; it != pending.end(); ++it)
+                if(before(*it, *best))
+                    best = it;
+            job = std::move(*best);
+            pending.erase(best);
+            clock = served[job.stream]++;
+            return true;
+        }
+
+        void close()
+        {
+            {
+                auto lock = std::lock_guard<std::mutex> { mutex };
+                closed = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    class Host
+    {
+        // SERVES JOBS FOR ANY NUMBER OF SHADERS FROM ONE PROCESS. JOBS RUN ONE FRAME AT A TIME ACROSS THE WHOLE POOL, SINCE
+        // SS::RES, SS::TIME AND CACHED OR DEFERRED STATE ARE PER FRAME, WHILE I/O THREADS ENCODE AND WRITE FINISHED ONES.
+        using Program = std::function<void(Pool&, Vram&, Tiler&)>;
+        std::vector<std::pair<std::string, Program>> programs {};
+        std::mutex out {};
+        const int cpus {};
+        Interleave interleave { 1, nullptr };
+        Coarse coarse;
+        const Samples samples { nullptr };
+        const bool dither { option("SS_DITHER", 0) != 0 };
+
+        void reply(const std::string& line)
+        {
+            auto lock = std::lock_guard<std::mutex> { out };
+            std::fputs(line.c_str(), stdout);
+            std::fflush(stdout);
+        }
+
+        void fail(const Job& job, const char* error)
+        {
+            const auto shader = escaped(job.shader);
+            auto line = std::vector<char>(shader.size() + 128);
+            std::snprintf(line.data(), line.size(), "{\"job\": %u, \"shader\": \"%s\", \"error\": \"%s\"}\n", job.id, shader.c_str(), error);
+            reply(line.data());
+        }
+
+        const Program* find(const std::string& name) const
+        {
+            for(const auto& [key, program] : programs)
+                if(key == name)
+                    return &program;
+            return nullptr;
+        }
+
+    public:
+        Host(int cpus)
+            : cpus { cpus }
+            , coarse { cpus, 1, 8 }
+        {
+        }
+
+        template<typename S>
+        void add(const std::string& name, S shade)
+        {
+            programs.emplace_back(name, [this, shade](Pool& pool, Vram& vram, Tiler& tiler) { draw(pool, vram, tiler, shade, interleave, coarse, samples); });
+        }
+
+        void serve(const char* source)
+        {
+            // SS_SERVE NAMES A FILE OR FIFO OF JOB LINES, OR - FOR STDIN. EACH FINISHED JOB PRINTS ONE JSON LINE TO STDOUT.
+            const auto input = std::strcmp(source, "-") == 0 ? stdin : std::fopen(source, "r");
+            if(!input)
+            {
+                std::fprintf(stderr, "serve: cannot read %s\n", source);
+                return;
+            }
+            const auto schedule = std::getenv("SS_SCHEDULE");
+            auto jobs = Jobs { !schedule || std::strcmp(schedule, "priority") != 0 };
+            auto pool = Pool { cpus };
+            auto tiler = Tiler { pool, option("SS_TILE", 32) };
+            auto chain = Chain { std::max(1, option("SS_BUFFERS", 4)) };
+            for(auto& frame : chain.frames)
+                tiler.place(pool, frame.vram);
+            auto slots = std::vector<Job>(chain.frames.size());
+            auto reader = std::thread { [&] {
+                label("reader");
+                char line[1024];
+                for(uint32_t id = 0; std::fgets(line, sizeof(line), input);)
+                {
+                    if(line[std::strspn(line, " \t\r\n")] == '\0')
+                        continue;
+                    auto job = Job {};
+                    if(!parse(line, id, job))
+                    {
+                        job.id = id;
+                        fail(job, "malformed job");
+                    }
+                    else
+                    {
+                        job.queued = std::chrono::high_resolution_clock::now();
+                        jobs.push(std::move(job));
+                    }
+                    id++;
+                }
+                jobs.close();
+            } };
+            auto writers = std::vector<std::thread> {};
+            for(int i = 0; i < std::max(1, option("SS_WRITERS", 2)); i++)
+                writers.push_back(std::thread { [&, i] {
+                    label("writer", i);
+                    auto bytes = std::vector<uint8_t> {};
+                    for(int slot; chain.present(slot);)
+                    {
+                        const auto job = slots[slot];
+                        const auto& vram = chain.frames[slot].vram;
+                        const auto ends = [&](const char* suffix) {
+                            const auto n = std::strlen(suffix);
+                            return job.output.size() >= n && job.output.compare(job.output.size() - n, n, suffix) == 0;
+                        };
+                        const auto dot = job.output.rfind('.');
+                        auto header = std::string {};
+                        const char* error {};
+                        {
+                            const auto span = Span { "encode", job.id };
+                            if(ends(".y4m"))
+                            {
+                                header = "YUV4MPEG2 W" + std::to_string(vram.width) + " H" + std::to_string(vram.height) + " F" + std::to_string(job.fps) + ":1 Ip A1:1 C444\n";
+                                y4m(vram, bytes);
+                            }
+                            else if(ends(".rgba"))
+                                rgba(vram, bytes);
+                            else if(auto format = Format {}; dot != std::string::npos && parse(job.output.substr(dot + 1), format))
+                            {
+                                if(format == Format::rgb10 && !vram.deep())
+                                    error = "rgb10 needs float colors";
+                                else
+                                    raw(vram, format, dither, bytes);
+                            }
+                            else
+                                png(vram, bytes);
+                        }
+                        chain.release(slot);
+                        if(error)
+                        {
+                            fail(job, error);
+                            continue;
+                        }
+                        const auto span = Span { "write", job.id };
+                        const auto file = std::fopen(job.output.c_str(), "wb");
+                        if(!file)
+                        {
+                            fail(job, "cannot write output");
+                            continue;
+                        }
+                        std::fwrite(header.data(), 1, header.size(), file);
+                        std::fwrite(bytes.data(), 1, bytes.size(), file);
+                        std::fclose(file);
+                        const auto waited = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - job.queued).count();
+                        const auto shader = escaped(job.shader);
+                        const auto stream = escaped(job.stream);
+                        const auto output = escaped(job.output);
+                        auto line = std::vector<char>(shader.size() + stream.size() + output.size() + 256);
+                        std::snprintf(line.data(), line.size(),
+                            "{\"job\": %u, \"shader\": \"%s\", \"stream\": \"%s\", \"time_ms\": %.3f, \"width\": %d, \"height\": %d, "
+                            "\"priority\": %d, \"render_ms\": %.3f, \"latency_ms\": %.3f, \"output\": \"%s\"}\n",
+                            job.id, shader.c_str(), stream.c_str(), double(job.time) * 1e3, job.width, job.height,
+                            job.priority, job.dt * 1e3, waited * 1e3, output.c_str());
+                        reply(line.data());
+                    }
+                } });
+            auto served = 0;
+            const auto seconds = timed([&] {
+                for(auto job = Job {}; jobs.pop(job);)
+                {
+                    const auto program = find(job.shader);
+                    if(!program)
+                    {
+                        fail(job, "unknown shader");
+                        continue;
+                    }
+                    if(job.width <= 0 || job.height <= 0 || job.width > 16384 || job.height > 16384)
+                    {
+                        fail(job, "bad resolution");
+                        continue;
+                    }
+                    resize(job.width, job.height);
+                    if(xres != job.width || yres != job.height)
+                    {
+                        // SS_STATIC_RES BUILDS CANNOT CHANGE RESOLUTION.
+                        fail(job, "resolution is fixed at compile time");
+                        continue;
+                    }
+                    int slot;
+                    if(!chain.acquire(slot))
+                        break;
+                    auto& back = chain.frames[slot];
+                    if(back.vram.width != job.width || back.vram.height != job.height)
+                    {
+                        back.vram.own(job.width, job.height);
+                        tiler.place(pool, back.vram);
+                    }
+                    // ONLY RGB10 JOBS KEEP THEIR FLOAT COLORS.
+                    const auto dot = job.output.rfind('.');
+                    auto format = Format {};
+                    back.vram.deepen(dot != std::string::npos && parse(job.output.substr(dot + 1), format) && format == Format::rgb10);
+                    back.id = job.id;
+                    time = job.time;
+                    tiler.cut(job.width, job.height);
+                    job.dt = timed([&] {
+                        const auto span = Span { "draw", advance() };
+                        (*program)(pool, back.vram, tiler);
+                    });
+                    slots[slot] = std::move(job);
+                    chain.submit(slot);
+                    served++;
+                }
+                // EVERY SUBMITTED FRAME IS BACK ON THE FREE LIST ONCE IT HAS BEEN ENCODED.
+                for(int slot, i = 0; i < int(chain.frames.size()) && chain.acquire(slot); i++)
+                {
+                }
+            });
+            chain.close();
+            for(auto& thread : writers)
+                thread.join();
+            reader.join();
+            if(input != stdin)
+                std::fclose(input);
+            std::fprintf(stderr, "serve: %d jobs in %.3f s (%.3f jobs/s)\n", served, seconds, served / seconds);
+        }
+    };
+
+    using Draw = std::function<void(Pool&, Vram&, Tiler&, Interleave&, Coarse&, const Samples&, V2)>;
+
+    struct Entry
+    {
+        std::string name {};
+        Motion motion {};
+        std::shared_ptr<const Draw> draw {};
+        bool planar {};
+    };
+
+    class Registry
+    {
+        // SHADERS ENROLL FROM STATIC INITIALIZERS, AT STARTUP AND WHEN A SHADER MODULE IS OPENED WHILE FRAMES ARE BEING
+        // SHADED, SO EVERY ACCESS TAKES THE LOCK. ENROLLING A NAME TWICE REPLACES THAT SHADER IN PLACE. A FRAME ALREADY
+        // RUNNING THE OLD SHADER HOLDS ITS OWN REFERENCE AND FINISHES WITH IT.
+        mutable std::mutex mutex {};
+        std::vector<Entry> entries {};
+        std::string latest {};
+        uint64_t enrolled {};
+
+    public:
+        void add(Entry entry)
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            latest = entry.name;
+            enrolled++;
+            for(auto& other : entries)
+                if(other.name == entry.name)
+                {
+                    other = std::move(entry);
+                    return;
+                }
+            entries.push_back(std::move(entry));
+        }
+
+        Entry at(int index) const
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            return entries[index];
+        }
+
+        int size() const
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            return int(entries.size());
+        }
+
+        int find(const std::string& name) const
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            for(int i = 0; i < int(entries.size()); i++)
+                if(entries[i].name == name)
+                    return i;
+            return -1;
+        }
+
+        void sort()
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+        }
+
+        uint64_t count() const
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            return enrolled;
+        }
+
+        std::string last() const
+        {
+            auto lock = std::lock_guard<std::mutex> { mutex };
+            return latest;
+        }
+    };
+
+    inline Registry& registry()
+    {
+        static auto shaders = Registry {};
+        return shaders;
+    }
+
+    template<typename S>
+    bool enroll(const char* name, S shade, Motion motion = nullptr)
+    {
+        // CALLED FROM A STATIC INITIALIZER IN EACH SHADER FILE. THE PIXEL LOOP IS STILL SPECIALIZED FOR S, ONLY THE
+        // CALL INTO IT ONCE PER FRAME GOES THROUGH THE REGISTRY.
+        registry().add(Entry { name, motion, std::make_shared<const Draw>([shade](Pool& pool, Vram& vram, Tiler& tiler, Interleave& interleave, Coarse& coarse, const Samples& samples, V2 zoom) {
+            draw(pool, vram, tiler, shade, interleave, coarse, samples, zoom);
+        }), floats(shade) });
+        return true;
+    }
+
+    class Program
+    {
+        // THE REGISTERED SHADER BEING SHADED. COPIES SHARE THE SELECTION, SO INPUT ON THE MAIN THREAD CAN SWITCH THE SHADER
+        // DRAWN BY THE SHADING THREAD. A SWITCH OR A RELOAD TAKES EFFECT AT THE NEXT FRAME.
+        struct State
+        {
+            std::atomic<int> selected {};
+            std::shared_ptr<const Draw> drawn {};
+        };
+
+        std::shared_ptr<State> state { std::make_shared<State>() };
+
+    public:
+        Program(int index)
+        {
+            state->selected = index;
+        }
+
+        void cycle(int step) const
+        {
+            const auto count = registry().size();
+            state->selected = ((state->selected + step) % count + count) % count;
+            std::fprintf(stderr, "shader: %s\n", registry().at(state->selected).name.c_str());
+        }
+
+        void draw(Pool& pool, Vram& vram, Tiler& tiler, Interleave& interleave, Coarse& coarse, const Samples& samples, V2 zoom) const
+        {
+            const auto entry = registry().at(state->selected);
+            if(state->drawn != entry.draw)
+                interleave.restart(entry.motion);
+            state->drawn = entry.draw;
+            (*entry.draw)(pool, vram, tiler, interleave, coarse, samples, zoom);
+        }
+
+        bool planar() const
+        {
+            return registry().at(state->selected).planar;
+        }
+    };
+
+    inline void draw(Pool& pool, Vram& vram, Tiler& tiler, const Program& program, Interleave& interleave, Coarse& coarse, const Samples& samples, V2 zoom = V2 { 1.f })
+    {
+        program.draw(pool, vram, tiler, interleave, coarse, samples, zoom);
+    }
+
+    inline bool floats(const Program& program)
+    {
+        return program.planar();
+    }
+
+    template<typename S>
+    void cycle(const S&, int)
+    {
+    }
+
+    inline void cycle(const Program& program, int step)
+    {
+        if(step != 0)
+            program.cycle(step);
+    }
+
+    template<typename S>
+    void run(S shade, const char* name = "shader", Motion motion = nullptr)
+    {
+        label("main");
+        resize(option("SS_XRES", xres), option("SS_YRES", yres));
+        auto vram = Vram {};
+        if(const auto source = std::getenv("SS_SERVE"))
+        {
+            auto host = Host { vram.cpus };
+            host.add(name, shade);
+            host.serve(source);
+            return;
+        }
+        if(option("SS_BENCH", 0) || option("SS_SCALING", 0))
+        {
+            measure(shade, name, motion);
+            return;
+        }
+        auto pool = Pool { vram.cpus };
+        auto tiler = Tiler { pool, option("SS_TILE", 32) };
+        auto adaptive = Adaptive { option("SS_ADAPTIVE", 0) * 1e-3 };
+        auto coarse = Coarse { vram.cpus, option("SS_COARSE", 1), option("SS_COARSE_ERROR", 4) };
+        // COARSE SHADING FILLS EVERY PIXEL FROM ONE SAMPLE ITSELF, SO IT TAKES PRECEDENCE OVER SUPERSAMPLING AND INTERLEAVING.
+        const auto samples = Samples { mode("SS_AA", !coarse.enabled()) };
+        auto interleave = Interleave { mode("SS_INTERLEAVE", !coarse.enabled()) ? option("SS_INTERLEAVE", 1) : 1, motion };
+        if(const auto format = std::getenv("SS_RENDER"))
+        {
+            render(pool, tiler, shade, interleave, coarse, samples, format);
+            return;
+        }
+        if(option("SS_HEADLESS", 0))
+        {
+            // NO WINDOW, RENDERER OR VSYNC. SHADES SS_FRAMES FRAMES INTO THE OWNED FRAMEBUFFER AND EXITS.
+            vram.own();
+            tiler.place(pool, vram);
+            for(int frame = 0, frames = option("SS_FRAMES", 300); frame < frames; frame++)
+            {
+                tick();
+                const auto dt = timed([&] {
+                    const auto span = Span { "draw", advance() };
+                    draw(pool, vram, tiler, shade, interleave, coarse, samples, adaptive);
+                });
+                adaptive.update(dt);
+                report(dt, adaptive, adaptive.scale, coarse.fraction);
+            }
+            return;
+        }
+        auto video = Video {};
+        const auto depth = option("SS_BUFFERS", 2);
+        if(depth > 0)
+        {
+            pipeline(pool, tiler, shade, interleave, coarse, samples, adaptive, video, depth);
+            return;
+        }
+        // SS_BUFFERS=0 SHADES STRAIGHT INTO THE LOCKED TEXTURE, ONE STEP AFTER ANOTHER, FOR THE LOWEST LATENCY.
+        for(auto input = Input {}; !input.done; input.update())
+        {
+            cycle(shade, input.step);
+            tick();
+            const auto id = advance();
+            vram.lock(video.texture);
+            const auto dt = timed([&] {
+                const auto span = Span { "draw", id };
+                draw(pool, vram, tiler, shade, interleave, coarse, samples, adaptive);
+            });
+            {
+                const auto span = Span { "upload", id };
+                vram.unlock();
+            }
+            {
+                const auto span = Span { "present", id };
+                video.render();
+            }
+            adaptive.update(dt);
+            report(dt, adaptive, adaptive.scale, coarse.fraction);
+        }
+    }
+
+#ifdef __linux__
+    class Reload
+    {
+        // WATCHES A SHADER MODULE, A SHADER FILE BUILT WITH -SHARED -FPIC, AND OPENS EVERY NEW BUILD OF IT. OPENING RUNS THE
+        // MODULE'S SS::ENROLL, WHICH SWAPS THE REGISTERED SHADER OF THE SAME NAME BETWEEN TWO FRAMES, WHILE THE WINDOW, POOL,
+        // TILER AND HISTORY STAY UP. THE HOST IS LINKED WITH -RDYNAMIC SO A MODULE SHARES ITS REGISTRY, RESOLUTION AND CLOCK.
+        // EACH BUILD IS OPENED FROM A PRIVATE COPY, AS DLOPEN HANDS BACK THE OLD IMAGE FOR A FILE IT ALREADY HAS OPEN, AND
+        // IS NEVER CLOSED, AS A FRAME OR THE SHADER'S HISTORY MAY STILL REFER TO ITS CODE.
+        const std::string path {};
+        std::atomic<bool> stop { false };
+        std::thread watcher {};
+        int loads {};
+
+        static bool copy(const char* from, const char* to)
+        {
+            const auto in = std::fopen(from, "rb");
+            if(!in)
+                return false;
+            const auto out = std::fopen(to, "wb");
+            auto ok = out != nullptr;
+            char buffer[1 << 16];
+            for(size_t n; ok && (n = std::fread(buffer, 1, sizeof(buffer), in)) > 0;)
+                ok = std::fwrite(buffer, 1, n, out) == n;
+            std::fclose(in);
+            if(out)
+                ok = std::fclose(out) == 0 && ok;
+            return ok;
+        }
+
+        bool load()
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            char image[64];
+            std::snprintf(image, sizeof(image), "/tmp/ss-%d-%d.so", int(getpid()), loads++);
+            if(!copy(path.c_str(), image))
+            {
+                std::fprintf(stderr, "reload: cannot copy %s\n", path.c_str());
+                return false;
+            }
+            const auto before = registry().count();
+            const auto handle = dlopen(image, RTLD_NOW | RTLD_LOCAL);
+            std::remove(image);
+            if(!handle)
+            {
+                std::fprintf(stderr, "reload: %s\n", dlerror());
+                return false;
+            }
+            if(registry().count() == before)
+            {
+                std::fprintf(stderr, "reload: %s enrolls no shader\n", path.c_str());
+                return false;
+            }
+            name = registry().last();
+            const auto ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            std::fprintf(stderr, "reload: %s from %s in %.3f ms\n", name.c_str(), path.c_str(), ms);
+            return true;
+        }
+
+        void watch()
+        {
+            // WATCHES THE DIRECTORY, NOT THE FILE, SINCE LINKERS OFTEN REPLACE THE OUTPUT WITH A NEW FILE RATHER THAN REWRITE IT.
+            label("reload");
+            const auto slash = path.rfind('/');
+            const auto dir = slash == std::string::npos ? std::string { "." } : slash == 0 ? std::string { "/" } : path.substr(0, slash);
+            const auto file = slash == std::string::npos ? path : path.substr(slash + 1);
+            const auto fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if(fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+            {
+                std::fprintf(stderr, "reload: cannot watch %s\n", dir.c_str());
+                if(fd >= 0)
+                    close(fd);
+                return;
+            }
+            alignas(inotify_event) char buffer[4096];
+            while(!stop)
+            {
+                auto wait = pollfd { fd, POLLIN, 0 };
+                if(poll(&wait, 1, 100) <= 0)
+                    continue;
+                auto changed = false;
+                for(ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;)
+                    for(auto at = buffer; at < buffer + n;)
+                    {
+                        const auto event = reinterpret_cast<const inotify_event*>(at);
+                        changed |= event->len > 0 && file == event->name;
+                        at += sizeof(inotify_event) + event->len;
+                    }
+                if(changed)
+                    load();
+            }
+            close(fd);
+        }
+
+    public:
+        // THE SHADER THE MODULE ENROLLED. EMPTY IF THE FIRST LOAD FAILED.
+        std::string name {};
+        Reload(const char* path)
+            : path { path }
+        {
+            if(load())
+                watcher = std::thread { [this] { watch(); } };
+        }
+
+        Reload(const Reload&) = delete;
+        Reload& operator=(const Reload&) = delete;
+
+        ~Reload()
+        {
+            stop = true;
+            if(watcher.joinable())
+                watcher.join();
+        }
+    };
+#endif
+
+    inline int launch(int argc, char** argv)
+    {
+        // ONE EXECUTABLE FOR EVERY SHADER LINKED IN. WITH NO ARGUMENTS IT RUNS THE FIRST SHADER BY NAME, SO A BINARY
+        // LINKING ONE SHADER BEHAVES AS BEFORE. --BENCH ALL BENCHMARKS THE WHOLE CATALOG IN ONE PROCESS, ONE JSON LINE
+        // PER SHADER, EACH ON A FRESH POOL SO NO COUNTERS CARRY OVER. SS_RELOAD NAMES A SHADER MODULE TO OPEN AND WATCH,
+        // WHOSE SHADER RUNS UNLESS ANOTHER IS NAMED.
+        auto& shaders = registry();
+        shaders.sort();
+        auto reloaded = std::string {};
+#ifdef __linux__
+        auto reload = std::unique_ptr<Reload> {};
+        if(const auto path = std::getenv("SS_RELOAD"))
+        {
+            reload = std::make_unique<Reload>(path);
+            if(reload->name.empty())
+                return 1;
+            reloaded = reload->name;
+        }
+#else
+        if(std::getenv("SS_RELOAD"))
+            std::fprintf(stderr, "launch: SS_RELOAD needs linux\n");
+#endif
+        const auto args = std::vector<std::string>(argv + 1, argv + argc);
+        if(args.size() == 1 && args[0] == "--list")
+        {
+            for(int i = 0; i < shaders.size(); i++)
+                std::printf("%s\n", shaders.at(i).name.c_str());
+            return 0;
+        }
+        if(args.size() == 2 && args[0] == "--bench")
+        {
+            if(args[1] != "all" && shaders.find(args[1]) < 0)
+            {
+                std::fprintf(stderr, "launch: no shader named %s\n", args[1].c_str());
+                return 1;
+            }
+            label("main");
+            resize(option("SS_XRES", xres), option("SS_YRES", yres));
+            for(int i = 0; i < shaders.size(); i++)
+            {
+                const auto name = shaders.at(i).name;
+                if(args[1] != "all" && name != args[1])
+                    continue;
+                measure(Program { i }, name.c_str());
+            }
+            return 0;
+        }
+        if(shaders.size() == 0 || args.size() > 1 || (args.size() == 1 && shaders.find(args[0]) < 0))
+        {
+            std::fprintf(stderr, "usage: %s [shader | --list | --bench all | --bench shader]\nshaders:", argv[0]);
+            for(int i = 0; i < shaders.size(); i++)
+                std::fprintf(stderr, " %s", shaders.at(i).name.c_str());
+            std::fprintf(stderr, "\n");
+            return 1;
+        }
+        if(const auto source = std::getenv("SS_SERVE"))
+        {
+            // EVERY REGISTERED SHADER CAN BE NAMED BY A JOB.
+            label("main");
+            resize(option("SS_XRES", xres), option("SS_YRES", yres));
+            auto host = Host { Vram {}.cpus };
+            for(int i = 0; i < shaders.size(); i++)
+                host.add(shaders.at(i).name, Program { i });
+            host.serve(source);
+            return 0;
+        }
+        const auto index = shaders.find(!args.empty() ? args[0] : !reloaded.empty() ? reloaded : shaders.at(0).name);
+        run(Program { index }, shaders.at(index).name.c_str());
+        return 0;
     }
 }
@@ -2,18 +2,50 @@
 
 #include "softshader.hh"
 
-static uint32_t shade(const ss::V2 coord)
+namespace
 {
-    const auto p = (ss::res * -1.f + coord * 2.f) / ss::res.y;
-    const auto a = ss::atan2(p.y, p.x);
-    const auto r = ss::pow(ss::pow(p.x * p.x, 4.f) + ss::pow(p.y * p.y, 4.f), 1.f / 8.f);
-    const auto uv = ss::V2(r == 0.f ? 1.f : (1.f / r) + 0.2f * ss::uptime(), a);
-    const auto f = ss::cos(12.f * uv.x) * ss::cos(6.f * uv.y);
-    const auto v = (ss::sin({ ss::V3 { 0.f, 0.5f, 1.f } + ss::PI * f }) * 0.5f + 0.5f) * r;
-    return v.color(1.0f);
-}
+    using V2 = ss::V2p<ss::lanes>;
+    using V3 = ss::V3p<ss::lanes>;
 
-int main()
-{
-    ss::run(shade);
+    // THE ANGLE AND RADIUS OF A PIXEL NEVER CHANGE, SO ATAN2, THE POWS AND THE ANGULAR COS ARE TAKEN ONCE PER RESOLUTION.
+    // 1 / R IS CHEAPER TO RECOMPUTE THAN TO STREAM IN FROM A THIRD ARRAY.
+
+    struct Polar
+    {
+        ss::FArray r;
+        ss::FArray wave;
+        Polar(int size)
+            : r { size }
+            , wave { size }
+        {
+        }
+    };
+
+    void setup(Polar& polar, const int* index, const V2 coord, const ss::Uniforms& u)
+    {
+        const auto p = (V2 { u.res } * -1.f + coord * 2.f) / u.res.y;
+        const auto a = ss::atan2(p.y, p.x);
+        const auto r = ss::pow(ss::pow(p.x * p.x, 4.f) + ss::pow(p.y * p.y, 4.f), 1.f / 8.f);
+        ss::scatter(polar.r, index, r);
+        ss::scatter(polar.wave, index, ss::cos(a * 6.f));
+    }
+
+    V3 shade(const Polar& polar, const int* index, const V2, const ss::Uniforms& u)
+    {
+        const auto r = ss::gather(polar.r, index);
+        const auto x = ss::select(r == 0.f, 1.f, 1.f / r + 0.2f * u.time);
+        const auto f = ss::cos(x * 12.f) * ss::gather(polar.wave, index);
+        return (ss::sin(V3 { ss::V3 { 0.f, 0.5f, 1.f } } + f * ss::PI) * 0.5f + 0.5f) * r;
+    }
+
+    ss::V2 motion(const ss::V2 coord, float dt, const ss::Uniforms& u)
+    {
+        // THE TUNNEL SCROLLS AS 1 / R + 0.2 * TIME, SO A POINT AT RADIUS R WAS AT R / (1 + 0.2 * DT * R) DT SECONDS AGO.
+        const auto p = (u.res * -1.f + coord * 2.f) / u.res.y;
+        const auto r = ss::pow(ss::pow(p.x * p.x, 4.f) + ss::pow(p.y * p.y, 4.f), 1.f / 8.f);
+        const auto q = p / (1.f + 0.2f * dt * r);
+        return (q * u.res.y + u.res) * 0.5f;
+    }
+
+    const auto enrolled = ss::enroll("tunnel", ss::Cached<Polar, V3> { setup, shade }, motion);
 }